@@ -15,25 +15,175 @@
 
 #include "Core/Input.h"
 #include <Core/Console.h>
+#include <Core/FramePacer.h>
+#include <Core/JobSystem.h>
+#include <Core/Profiler.h>
+#include <Core/Time.h>
+#include <RHI/CommandBuffer.h>
 #include <RHI/Context.h>
+#include <RHI/ShaderArchive.h>
+#include <RHI/UploadRing.h>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <string_view>
+#include <thread>
 
-int main()
+int main(int argc, char** argv)
 {
+    // --record <file> captures the session's input, --replay <file> runs it again in place of
+    // live input so frame times can be compared between builds, the null RHI backend runs it
+    // without a display. --event-thread renders on a separate thread
+    // so OS events are pumped without waiting on SwapBuffers. --frames <count> closes the window
+    // after that many frames, for timing runs with the null RHI backend
+    std::string_view record_path;
+    std::string_view replay_path;
+    bool event_thread   = false;
+    uint64_t max_frames = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg(argv[i]);
+        if (arg == "--record" && i + 1 < argc) {
+            record_path = argv[++i];
+        }
+        else if (arg == "--replay" && i + 1 < argc) {
+            replay_path = argv[++i];
+        }
+        else if (arg == "--frames" && i + 1 < argc) {
+            max_frames = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--event-thread") {
+            event_thread = true;
+        }
+    }
+    bool replaying = !replay_path.empty();
+    event_thread   = event_thread && !replaying;
+
     Console console;
+    JobSystem jobs;
     RenderHardwareContext context;
+    ShaderCache shader_cache;
+    ShaderArchive shader_archive;
+    RenderUploadRing uploads;
     Input input;
+    Time time;
+    FramePacer pacer;
 
+    PROFILE_THREAD_NAME("Main");
     console.Initialize();
     console.AddOutput<ConsoleTerminalOutput>();
+    jobs.Initialize();
+
+    if (replaying && !input.InitializeReplay(replay_path)) {
+        jobs.Destroy();
+        console.Destroy();
+        return 1;
+    }
 
     context.Initialize("KryosEngine");
-    input.Initialize(context.Window);
+    shader_cache.Initialize("Cache/Shaders");
+    std::filesystem::path archive_path = std::filesystem::path(argv[0]).parent_path();
+    if (shader_archive.Load((archive_path / "Shaders.kar").string())) {
+        INFO("Loaded {} shader variants", shader_archive.Header.EntryCount);
+    }
+    uploads.Initialize(4 << 20);
+    uploads.BeginFrame();
+    if (!replaying) {
+        input.Initialize(context.Window, event_thread ? Input_EventThreadBit : Input_NoneBit);
+        if (!record_path.empty()) {
+            input.StartRecording(record_path);
+        }
+    }
+    time.Initialize();
+    pacer.Initialize();
 
-    while (!context.Window.Closing()) {
+    // Draws recorded by jobs during the frame are replayed on the thread owning the context.
+    // Per-draw data is written into the upload ring, whose next region is claimed once the frame
+    // is submitted
+    RenderCommandQueue commands;
+    commands.Initialize(JobSystem::WorkerCount() + 1);
+    auto render_frame = [&]() {
+        commands.Execute();
+        commands.Reset();
+        uploads.EndFrame();
         context.Window.SwapBuffers();
-        input.PollEvents();
+        uploads.BeginFrame();
+        if (max_frames > 0 && time.FrameCount >= max_frames) {
+            context.Window.Close();
+        }
+    };
+
+    if (event_thread) {
+        // The render thread owns the GL context and samples input right before simulating,
+        // this thread only pumps OS events until the window closes
+        WindowHandle::ClearCurrentContext();
+        std::thread render_thread([&]() {
+            PROFILE_THREAD_NAME("Render");
+            context.Window.MakeCurrentContext();
+            while (!context.Window.Closing()) {
+                PROFILE_SCOPE("Frame");
+                time.Update();
+                input.PollEvents();
+                render_frame();
+                if (Input::WindowFocused()) {
+                    pacer.Wait();
+                }
+                else {
+                    std::chrono::duration<double> idle(pacer.IdleTimeout());
+                    std::this_thread::sleep_for(idle);
+                    pacer.Reset();
+                }
+            }
+            WindowHandle::ClearCurrentContext();
+        });
+
+        // Gamepads have no events to wake on, so keep the pump ticking at a high rate
+        while (!context.Window.Closing()) {
+            Input::PumpEvents(0.002);
+        }
+        render_thread.join();
+        context.Window.MakeCurrentContext();
+    }
+
+    while (!event_thread && !context.Window.Closing() && !input.ReplayFinished()) {
+        PROFILE_SCOPE("Frame");
+        if (replaying) {
+            time.Update(input.ReplayDeltaTime());
+        }
+        else {
+            time.Update();
+        }
+        render_frame();
+
+        // Replays run unpaced so the frame times measure the frame body alone, unfocused editors
+        // block on events instead of rendering flat out
+        if (replaying) {
+            input.PollEvents();
+        }
+        else if (context.Window.Focused()) {
+            input.PollEvents();
+            pacer.Wait();
+        }
+        else {
+            input.PollEvents(pacer.IdleTimeout());
+            pacer.Reset();
+        }
+    }
+
+    if (replaying || max_frames > 0) {
+        FrameTimeStats stats = time.FrameStats();
+        INFO("Ran {} frames, frame time avg {:.3f}ms p50 {:.3f}ms p95 {:.3f}ms p99 {:.3f}ms",
+             time.FrameCount, stats.Average, stats.P50, stats.P95, stats.P99);
+        RenderStateCounters counters = context.StateCounters();
+        INFO("Render state changes issued {} skipped {}", counters.Issued, counters.Skipped);
+        INFO("Upload ring stalled {} times for {:.3f}ms, peak {} bytes per frame",
+             uploads.Stats.StallCount, (double)uploads.Stats.StallNanoseconds / 1e6,
+             uploads.Stats.PeakFrameBytes);
     }
 
+    PROFILE_WRITE_TRACE("KryosTrace.json");
+    input.Destroy();
+    uploads.Destroy();
     context.Destroy();
+    jobs.Destroy();
     console.Destroy();
 }
@@ -0,0 +1,7 @@
+#pragma once
+
+layout(std140, binding = 0) uniform Material {
+    mat4 u_ModelViewProjection;
+    vec4 u_Color;
+    float u_AlphaCutoff;
+};
@@ -0,0 +1,54 @@
+#version 450 core
+#pragma keywords _ VERTEX_COLOR
+#pragma keywords _ TEXTURED
+#pragma keywords _ ALPHA_TEST
+
+#include <Material.glsl>
+
+#pragma stage vertex
+layout(location = 0) in vec3 a_Position;
+layout(location = 1) in vec2 a_TexCoord;
+#ifdef VERTEX_COLOR
+layout(location = 2) in vec4 a_Color;
+#endif
+
+layout(location = 0) out vec2 v_TexCoord;
+layout(location = 1) out vec4 v_Color;
+
+void main()
+{
+    v_TexCoord = a_TexCoord;
+#ifdef VERTEX_COLOR
+    v_Color = a_Color * u_Color;
+#else
+    v_Color = u_Color;
+#endif
+    gl_Position = u_ModelViewProjection * vec4(a_Position, 1.0);
+}
+
+#pragma stage fragment
+layout(location = 0) in vec2 v_TexCoord;
+layout(location = 1) in vec4 v_Color;
+layout(location = 0) out vec4 o_Color;
+
+#if defined(TEXTURED)
+layout(binding = 0) uniform sampler2D u_Texture;
+#endif
+
+void main()
+{
+    vec4 color = v_Color;
+#if defined(TEXTURED)
+    color *= texture(u_Texture, v_TexCoord);
+#endif
+#if defined(ALPHA_TEST) && !defined(VERTEX_COLOR)
+    if (color.a < u_AlphaCutoff) {
+        discard;
+    }
+#elif ALPHA_TEST
+    if (color.a * v_Color.a < u_AlphaCutoff) {
+        discard;
+    }
+#endif
+    o_Color = color;
+}
@@ -14,9 +14,50 @@
 // limitations under the License.
 
 #include "Core/Console.h"
+#include "Core/Profiler.h"
 #include <fmt/color.h>
 
-static Console* InstancePtr = nullptr;
+static thread_local fmt::memory_buffer s_FormatBuffer;
+static thread_local fmt::memory_buffer s_CaptureBuffer;
+static thread_local uint32_t s_FiberId = 0;
+
+// Set while this thread is writing to the outputs with OutputMutex held. Anything an output logs
+// from there goes straight to stderr rather than locking the mutex again
+static thread_local bool s_InOutput = false;
+
+static void FormatCondition(const ConsoleRecord& record, fmt::memory_buffer& out)
+{
+    if (record.Condition != nullptr) {
+        fmt::format_to(fmt::appender(out), "`{}` == FALSE: ", record.Condition);
+    }
+}
+
+// Plain stderr fallback for messages logged by an output, text already holds the condition
+static void WriteNested(const ConsoleRecord& record, const fmt::memory_buffer& text)
+{
+    fmt::memory_buffer out;
+    fmt::format_to(fmt::appender(out), "{} ",
+                   ConsoleMessage::SeverityFlagToCString(record.SeverityFlag));
+    if (record.Context != nullptr) {
+        fmt::format_to(fmt::appender(out), "[{}] ", record.Context);
+    }
+    out.append(text.data(), text.data() + text.size());
+    out.push_back('\n');
+    std::fwrite(out.data(), 1, out.size(), stderr);
+}
+
+static ConsoleMessage RecordToMessage(const ConsoleRecord& record, const fmt::memory_buffer& text)
+{
+    return ConsoleMessage {
+        .Line         = record.Line,
+        .Message      = std::string_view(text.data(), text.size()),
+        .File         = record.File,
+        .Function     = record.Function,
+        .Context      = record.Context,
+        .SeverityFlag = record.SeverityFlag,
+        .FiberId      = record.FiberId,
+    };
+}
 
 const char* ConsoleMessage::SeverityFlagToCString(ConsoleMessage::Severity severity)
 {
@@ -38,7 +79,7 @@ const char* ConsoleMessage::SeverityFlagToCString(ConsoleMessage::Severity sever
     }
 }
 
-std::string ConsoleOutput::_FormatHead(const ConsoleMessage& msg)
+void ConsoleOutput::_FormatHead(const ConsoleMessage& msg, fmt::memory_buffer& out)
 {
     fmt::text_style style;
     if (Flags & ConsoleOutput_ColorBit) {
@@ -68,39 +109,43 @@ std::string ConsoleOutput::_FormatHead(const ConsoleMessage& msg)
     }
 
     if (msg.Context != nullptr) {
-        return fmt::format(style, "{} [{}]",
-                           ConsoleMessage::SeverityFlagToCString(msg.SeverityFlag), msg.Context);
+        fmt::format_to(fmt::appender(out), style, "{} [{}]",
+                       ConsoleMessage::SeverityFlagToCString(msg.SeverityFlag), msg.Context);
     }
     else {
-        return fmt::format(style, "{}", ConsoleMessage::SeverityFlagToCString(msg.SeverityFlag));
+        fmt::format_to(fmt::appender(out), style, "{}",
+                       ConsoleMessage::SeverityFlagToCString(msg.SeverityFlag));
+    }
+    if (msg.FiberId != 0) {
+        fmt::format_to(fmt::appender(out), " (fiber {})", msg.FiberId);
     }
 }
 
-std::string ConsoleOutput::_FormatBody(const ConsoleMessage& msg)
+void ConsoleOutput::_FormatBody(const ConsoleMessage& msg, fmt::memory_buffer& out)
 {
-    std::string body;
-    body.append(fmt::format("{}", (Flags & ConsoleOutput_BreakAfterHeaderBit) ? "\n" : " "));
-    bool include_meta_info = false;
+    out.push_back((Flags & ConsoleOutput_BreakAfterHeaderBit) ? '\n' : ' ');
     if (msg.SeverityFlag > ConsoleMessage::Info) {
-        include_meta_info = true;
-        if (Flags & ~ConsoleOutput_FilterFileBit) {
-            body.append(fmt::format("file={} ", msg.File));
+        if (!(Flags & ConsoleOutput_FilterFileBit)) {
+            fmt::format_to(fmt::appender(out), "file={} ", msg.File);
         }
-        if (Flags & ~ConsoleOutput_FilterLineBit) {
-            body.append(fmt::format("line={} ", msg.Line));
+        if (!(Flags & ConsoleOutput_FilterLineBit)) {
+            fmt::format_to(fmt::appender(out), "line={} ", msg.Line);
         }
-        if (Flags & ~ConsoleOutput_FilterFunctionBit) {
-            body.append(fmt::format("func={} ", msg.Function));
+        if (!(Flags & ConsoleOutput_FilterFunctionBit)) {
+            fmt::format_to(fmt::appender(out), "func={} ", msg.Function);
+        }
+        if (Flags & ConsoleOutput_BreakAfterInfoBit) {
+            out.push_back('\n');
         }
     }
-    if (include_meta_info) {
-        body.append(fmt::format("{}{}", (Flags & ConsoleOutput_BreakAfterInfoBit) ? "\n" : "",
-                                msg.Message));
-    }
-    else {
-        body.append(msg.Message);
+    out.append(msg.Message.data(), msg.Message.data() + msg.Message.size());
+}
+
+void ConsoleOutput::PrintOutputBatch(const ConsoleMessage* msgs, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        PrintOutput(msgs[i]);
     }
-    return body;
 }
 
 void ConsoleTerminalOutput::Initialize(uint32_t flags)
@@ -111,52 +156,412 @@ void ConsoleTerminalOutput::Initialize(uint32_t flags)
 }
 
 void ConsoleTerminalOutput::PrintOutput(const ConsoleMessage& msg)
+{
+    _Write(msg);
+    if (Flags & ConsoleOutput_FlushPerMessageBit) {
+        std::fflush(msg.SeverityFlag > ConsoleMessage::Warning ? stderr : stdout);
+    }
+}
+
+void ConsoleTerminalOutput::PrintOutputBatch(const ConsoleMessage* msgs, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        _Write(msgs[i]);
+    }
+    std::fflush(stdout);
+    std::fflush(stderr);
+}
+
+void ConsoleTerminalOutput::_Write(const ConsoleMessage& msg)
 {
     FILE* out = stdout;
     if (msg.SeverityFlag > ConsoleMessage::Warning) {
         out = stderr;
     }
-    fmt::println(out, "{}{}", _FormatHead(msg), _FormatBody(msg));
-    if (Flags & ConsoleOutput_FlushPerMessageBit) {
-        std::fflush(out);
+    Buffer.clear();
+    _FormatHead(msg, Buffer);
+    _FormatBody(msg, Buffer);
+    Buffer.push_back('\n');
+    std::fwrite(Buffer.data(), 1, Buffer.size(), out);
+}
+
+void ConsoleRingBuffer::Initialize(size_t capacity)
+{
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
     }
+    Slots = new Slot[size];
+    Mask  = size - 1;
+    for (size_t i = 0; i < size; i++) {
+        Slots[i].Sequence.store(i, std::memory_order_relaxed);
+    }
+    EnqueuePos.store(0, std::memory_order_relaxed);
+    DequeuePos.store(0, std::memory_order_relaxed);
 }
 
-void Console::PrintToOutputs(int line, const std::string& msg, const char* file,
-                             const char* function, const char* context,
-                             ConsoleMessage::Severity severity)
+void ConsoleRingBuffer::Destroy()
 {
-    ConsoleMessage message {
-        .Line         = line,
-        .Message      = msg,
-        .File         = file,
-        .Function     = function,
-        .Context      = context,
-        .SeverityFlag = severity,
-    };
-    for (ConsoleOutput* output : InstancePtr->Outputs) {
-        if (InstancePtr->SeverityFlags & severity) {
-            output->PrintOutput(message);
+    delete[] Slots;
+    Slots = nullptr;
+    Mask  = 0;
+}
+
+bool ConsoleRingBuffer::TryPush(const ConsoleRecord& record)
+{
+    Slot* slot = nullptr;
+    size_t pos = EnqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        slot          = &Slots[pos & Mask];
+        size_t seq    = slot->Sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            return false;
+        }
+        else {
+            pos = EnqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    slot->Record = record;
+    slot->Sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool ConsoleRingBuffer::TryPop(ConsoleRecord& record)
+{
+    Slot* slot = nullptr;
+    size_t pos = DequeuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        slot          = &Slots[pos & Mask];
+        size_t seq    = slot->Sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (DequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            return false;
+        }
+        else {
+            pos = DequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+    record = slot->Record;
+    slot->Sequence.store(pos + Mask + 1, std::memory_order_release);
+    return true;
+}
+
+void Console::PrintToOutputs(const ConsoleRecord& record)
+{
+    PROFILE_SCOPE("Console::PrintToOutputs");
+    if (s_InOutput) {
+        fmt::memory_buffer text;
+        FormatRecord(record, text);
+        WriteNested(record, text);
+        return;
+    }
+    if (InstancePtr->SinkRunning.load(std::memory_order_relaxed) &&
+        InstancePtr->_Submit(record)) {
+        return;
+    }
+    InstancePtr->_WriteNow(record);
+}
+
+void Console::SetFiberId(uint32_t fiber_id)
+{
+    s_FiberId = fiber_id;
+}
+
+uint32_t Console::CurrentFiberId()
+{
+    return s_FiberId;
+}
+
+ConsoleContextId Console::InternContext(const char* context)
+{
+    if (context == nullptr) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(Contexts.Mutex);
+    uint32_t count = Contexts.Count.load(std::memory_order_relaxed);
+    for (uint32_t i = 1; i < count; i++) {
+        if (std::strcmp(Contexts.Names[i], context) == 0) {
+            return (ConsoleContextId)i;
         }
     }
+    if (count == ConsoleContextTable::Capacity) {
+        // Falls back to the unfiltered id, the message still carries its context string
+        return 0;
+    }
+    Contexts.Names[count] = context;
+    Contexts.Count.store(count + 1, std::memory_order_release);
+    return (ConsoleContextId)count;
 }
 
-void Console::Initialize(int severity_flags)
+const char* Console::ContextName(ConsoleContextId context_id)
 {
-    SeverityFlags = severity_flags;
-    InstancePtr   = this;
+    if (context_id >= Contexts.Count.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    return Contexts.Names[context_id];
+}
+
+void Console::SetContextFilter(const char* context, uint32_t suppressed_severity_flags)
+{
+    ConsoleContextId context_id = InternContext(context);
+    if (context != nullptr && context_id == 0) {
+        return;
+    }
+    Contexts.FilterFlags[context_id].store(suppressed_severity_flags, std::memory_order_relaxed);
+}
+
+void Console::FormatRecord(const ConsoleRecord& record, fmt::memory_buffer& out)
+{
+    FormatCondition(record, out);
+    try {
+        record.Formatter(record, out);
+    }
+    catch (const fmt::format_error& error) {
+        fmt::format_to(fmt::appender(out), "<format error: {}>", error.what());
+    }
+}
+
+void Console::Initialize(int severity_flags, uint32_t flags, ConsoleOverflowPolicy policy,
+                         size_t queue_capacity)
+{
+    SeverityFlags  = severity_flags;
+    Flags          = flags;
+    OverflowPolicy = policy;
+    InstancePtr    = this;
+
+    if (Flags & Console_AsyncBit) {
+        Queue.Initialize(queue_capacity);
+        SinkRunning.store(true);
+        SinkThread = std::thread(&Console::_SinkMain, this);
+    }
 }
 
 void Console::Destroy()
 {
+    if (SinkRunning.exchange(false)) {
+        {
+            std::lock_guard<std::mutex> lock(SinkMutex);
+            SinkSignal.notify_one();
+        }
+        SinkThread.join();
+
+        // Producers that saw the sink running may still be pushing, wait for them and write
+        // whatever they left in the queue on this thread
+        while (ActiveProducers.load() != 0) {
+            std::this_thread::yield();
+        }
+        ConsoleRecord record;
+        while (Queue.TryPop(record)) {
+            _WriteNow(record);
+            ConsumedCount.fetch_add(1);
+        }
+        Queue.Destroy();
+    }
+
     for (ConsoleOutput* output : Outputs) {
         output->Destroy();
         delete output;
     }
 }
 
+void Console::Flush()
+{
+    if (!SinkRunning.load(std::memory_order_relaxed) ||
+        std::this_thread::get_id() == SinkThread.get_id()) {
+        return;
+    }
+    uint64_t target = SubmittedCount.load();
+    while (ConsumedCount.load() < target) {
+        {
+            std::lock_guard<std::mutex> lock(SinkMutex);
+            SinkSignal.notify_one();
+        }
+        std::this_thread::yield();
+    }
+}
+
 void Console::AddOutput(ConsoleOutput* output, uint32_t flags)
 {
     output->Initialize(flags);
+    std::lock_guard<std::mutex> lock(OutputMutex);
     Outputs.push_back(output);
 }
+
+void Console::_FormatText(const ConsoleRecord& record, fmt::memory_buffer& out)
+{
+    out.append((const char*)record.Args, (const char*)record.Args + record.ArgsSize);
+}
+
+void Console::_PrintFormatted(ConsoleRecord& record, fmt::string_view format,
+                              fmt::format_args args)
+{
+    fmt::memory_buffer& text = s_CaptureBuffer;
+    text.clear();
+    try {
+        fmt::vformat_to(fmt::appender(text), format, args);
+    }
+    catch (const fmt::format_error& error) {
+        fmt::format_to(fmt::appender(text), "<format error: {}>", error.what());
+    }
+
+    record.Formatter = &Console::_FormatText;
+    if (text.size() <= ConsoleRecord::ArgStorageSize) {
+        std::memcpy(record.Args, text.data(), text.size());
+        record.ArgsSize = (uint16_t)text.size();
+        PrintToOutputs(record);
+        return;
+    }
+
+    if (s_InOutput) {
+        fmt::memory_buffer message;
+        FormatCondition(record, message);
+        message.append(text.data(), text.data() + text.size());
+        WriteNested(record, message);
+        return;
+    }
+
+    // Written directly once the sink has caught up, so it still lands after earlier messages
+    InstancePtr->Flush();
+    s_FormatBuffer.clear();
+    FormatCondition(record, s_FormatBuffer);
+    s_FormatBuffer.append(text.data(), text.data() + text.size());
+    InstancePtr->_WriteMessage(RecordToMessage(record, s_FormatBuffer));
+}
+
+bool Console::_Submit(const ConsoleRecord& record)
+{
+    // Outputs logging from inside the sink would deadlock on a full queue
+    if (std::this_thread::get_id() == SinkThread.get_id()) {
+        _WriteNow(record);
+        return true;
+    }
+
+    // Destroy clears SinkRunning before waiting on ActiveProducers, so a record is either pushed
+    // before the final drain or written synchronously by the caller, never left in the queue
+    ActiveProducers.fetch_add(1);
+    if (!SinkRunning.load()) {
+        ActiveProducers.fetch_sub(1);
+        return false;
+    }
+
+    // Fatal messages are followed by a trap, so they must never be dropped and must be written
+    // before returning to the caller
+    bool fatal   = record.SeverityFlag == ConsoleMessage::Fatal;
+    bool blocked = false;
+    while (!Queue.TryPush(record)) {
+        if (!fatal && OverflowPolicy == ConsoleOverflowPolicy_DropNewest) {
+            DroppedCount.fetch_add(1, std::memory_order_relaxed);
+            ActiveProducers.fetch_sub(1);
+            return true;
+        }
+        else if (!fatal && OverflowPolicy == ConsoleOverflowPolicy_DropOldest) {
+            ConsoleRecord evicted;
+            if (Queue.TryPop(evicted)) {
+                DroppedCount.fetch_add(1, std::memory_order_relaxed);
+                ConsumedCount.fetch_add(1);
+            }
+            continue;
+        }
+
+        if (!SinkRunning.load()) {
+            ActiveProducers.fetch_sub(1);
+            return false;
+        }
+        if (!blocked) {
+            blocked = true;
+            BlockedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        {
+            std::lock_guard<std::mutex> lock(SinkMutex);
+            SinkSignal.notify_one();
+        }
+        std::this_thread::yield();
+    }
+    SubmittedCount.fetch_add(1);
+
+    if (SinkSleeping.load()) {
+        std::lock_guard<std::mutex> lock(SinkMutex);
+        SinkSignal.notify_one();
+    }
+    ActiveProducers.fetch_sub(1);
+    if (fatal) {
+        Flush();
+    }
+    return true;
+}
+
+void Console::_WriteNow(const ConsoleRecord& record)
+{
+    s_FormatBuffer.clear();
+    FormatRecord(record, s_FormatBuffer);
+    _WriteMessage(RecordToMessage(record, s_FormatBuffer));
+}
+
+void Console::_WriteMessage(const ConsoleMessage& message)
+{
+    std::lock_guard<std::mutex> lock(OutputMutex);
+    s_InOutput = true;
+    for (ConsoleOutput* output : Outputs) {
+        output->PrintOutput(message);
+    }
+    s_InOutput = false;
+}
+
+void Console::_WriteToOutputs(const ConsoleMessage* msgs, size_t count)
+{
+    for (ConsoleOutput* output : Outputs) {
+        output->PrintOutputBatch(msgs, count);
+    }
+}
+
+void Console::_SinkMain()
+{
+    PROFILE_THREAD_NAME("Console Sink");
+    std::vector<ConsoleRecord> records(SinkBatchSize);
+    std::vector<fmt::memory_buffer> buffers(SinkBatchSize);
+    std::vector<ConsoleMessage> messages(SinkBatchSize);
+    for (;;) {
+        size_t count = 0;
+        while (count < SinkBatchSize && Queue.TryPop(records[count])) {
+            count++;
+        }
+        if (count > 0) {
+            PROFILE_SCOPE("Console::_SinkMain batch");
+            for (size_t i = 0; i < count; i++) {
+                buffers[i].clear();
+                FormatRecord(records[i], buffers[i]);
+                messages[i] = RecordToMessage(records[i], buffers[i]);
+            }
+            {
+                std::lock_guard<std::mutex> lock(OutputMutex);
+                s_InOutput = true;
+                _WriteToOutputs(messages.data(), count);
+                s_InOutput = false;
+            }
+            ConsumedCount.fetch_add(count);
+            continue;
+        }
+        if (!SinkRunning.load()) {
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(SinkMutex);
+        SinkSleeping.store(true);
+        SinkSignal.wait_for(lock, std::chrono::milliseconds(10), [this]() {
+            return !SinkRunning.load() || !Queue.Empty();
+        });
+        SinkSleeping.store(false);
+    }
+}
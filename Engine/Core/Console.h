@@ -23,21 +23,38 @@
 
 #define FUNCTION_STR __FUNCTION__
 
+#ifndef KRYOS_CONSOLE_MIN_SEVERITY
+#    ifdef NDEBUG
+#        define KRYOS_CONSOLE_MIN_SEVERITY Info
+#    else
+#        define KRYOS_CONSOLE_MIN_SEVERITY Verbose
+#    endif
+#endif
+
 // Internal
 // ------------------------------------------------------------------------------------------------
+// Severities below KRYOS_CONSOLE_MIN_SEVERITY are discarded at compile time. The context is
+// interned once per call site so the runtime filter is an integer lookup
+#define INTERNAL_LOG(_context, _condition, _severity, ...)                                        \
+    if constexpr (ConsoleMessage::_severity >= ConsoleMessage::KRYOS_CONSOLE_MIN_SEVERITY) {      \
+        static const ConsoleContextId internal_console_context_id =                               \
+            Console::InternContext(_context);                                                     \
+        Console::Log(__LINE__, __FILE__, FUNCTION_STR, (_context), internal_console_context_id,   \
+                     (_condition), ConsoleMessage::_severity, __VA_ARGS__);                       \
+    }                                                                                             \
+    else                                                                                          \
+        ((void)0)
+
 #define INTERNAL_MSG(_context, _severity, ...)                                                    \
-    Console::PrintToOutputs(__LINE__, fmt::format(__VA_ARGS__), __FILE__, FUNCTION_STR,           \
-                            (_context), ConsoleMessage::_severity)
+    INTERNAL_LOG(_context, nullptr, _severity, __VA_ARGS__)
 
 #define INTERNAL_MSG_RETURN(_context, _returning, _severity, ...)                                 \
-    Console::PrintToOutputs(__LINE__, fmt::format(__VA_ARGS__), __FILE__, FUNCTION_STR,           \
-                            (_context), ConsoleMessage::_severity);                               \
+    INTERNAL_LOG(_context, nullptr, _severity, __VA_ARGS__);                                      \
     return (_returning)
 
 #ifndef NDEBUG
 #    define INTERNAL_FATAL_MSG(_context, _severity, ...)                                          \
-        Console::PrintToOutputs(__LINE__, fmt::format(__VA_ARGS__), __FILE__, FUNCTION_STR,       \
-                                (_context), ConsoleMessage::_severity);                           \
+        INTERNAL_LOG(_context, nullptr, _severity, __VA_ARGS__);                                  \
         INTERNAL_GENERATE_TRAP()
 #else
 #    define INTERNAL_FATAL_MSG(_context, _severity, ...)
@@ -45,9 +62,7 @@
 
 #define INTERNAL_CONDITION(_context, _condition, _severity, ...)                                  \
     if (!(_condition)) {                                                                          \
-        Console::PrintToOutputs(                                                                  \
-            __LINE__, fmt::format(fmt::format("`{}` == FALSE: ", #_condition) + __VA_ARGS__),     \
-            __FILE__, FUNCTION_STR, (_context), ConsoleMessage::_severity);                       \
+        INTERNAL_LOG(_context, #_condition, _severity, __VA_ARGS__);                              \
         return;                                                                                   \
     }                                                                                             \
     else                                                                                          \
@@ -55,9 +70,7 @@
 
 #define INTERNAL_CONDITION_RETURN(_context, _returning, _condition, _severity, ...)               \
     if (!(_condition)) {                                                                          \
-        Console::PrintToOutputs(                                                                  \
-            __LINE__, fmt::format(fmt::format("`{}` == FALSE: ", #_condition) + __VA_ARGS__),     \
-            __FILE__, FUNCTION_STR, (_context), ConsoleMessage::_severity);                       \
+        INTERNAL_LOG(_context, #_condition, _severity, __VA_ARGS__);                              \
         return (_returning);                                                                      \
     }                                                                                             \
     else                                                                                          \
@@ -66,9 +79,7 @@
 #ifndef NDEBUG
 #    define INTERNAL_FATAL_CONDITION(_context, _condition, _severity, ...)                        \
         if (!(_condition)) {                                                                      \
-            Console::PrintToOutputs(                                                              \
-                __LINE__, fmt::format(fmt::format("`{}` == FALSE: ", #_condition) + __VA_ARGS__), \
-                __FILE__, FUNCTION_STR, (_context), ConsoleMessage::_severity);                   \
+            INTERNAL_LOG(_context, #_condition, _severity, __VA_ARGS__);                          \
             INTERNAL_GENERATE_TRAP();                                                             \
         }                                                                                         \
         else                                                                                      \
@@ -183,11 +194,44 @@
         CONTEXT_CONDITION_WARN_RETURN("VULKAN", _condition, _returning, __VA_ARGS__)
 #    define RHI_CONDITION_ERROR_RETURN(_condition, _returning, ...)                               \
         CONTEXT_CONDITION_ERROR_RETURN("VULKAN", _condition, _returning, __VA_ARGS__)
+#elif KRYOS_RHI_NULL
+#    define RHI_VERBOSE(...) CONTEXT_VERBOSE("NULL", __VA_ARGS__)
+#    define RHI_TRACE(...) CONTEXT_TRACE("NULL", __VA_ARGS__)
+#    define RHI_INFO(...) CONTEXT_INFO("NULL", __VA_ARGS__)
+#    define RHI_WARN(...) CONTEXT_WARN("NULL", __VA_ARGS__)
+#    define RHI_ERROR(...) CONTEXT_ERROR("NULL", __VA_ARGS__)
+#    define RHI_FATAL(...) CONTEXT_FATAL("NULL", __VA_ARGS__)
+
+#    define RHI_WARN_RETURN(_returning, ...) CONTEXT_WARN_RETURN("NULL", _returning, __VA_ARGS__)
+#    define RHI_ERROR_RETURN(_returning, ...)                                                     \
+        CONTEXT_ERROR_RETURN("NULL", _returning, __VA_ARGS__)
+#    define RHI_FATAL_RETURN(_returning, ...)                                                     \
+        CONTEXT_ERROR_RETURN("NULL", _returning, __VA_ARGS__)
+
+#    define RHI_CONDITION_WARN(_condition, ...)                                                   \
+        CONTEXT_CONDITION_WARN("NULL", _condition, __VA_ARGS__)
+#    define RHI_CONDITION_ERROR(_condition, ...)                                                  \
+        CONTEXT_CONDITION_ERROR("NULL", _condition, __VA_ARGS__)
+#    define RHI_CONDITION_FATAL(_condition, ...)                                                  \
+        CONTEXT_CONDITION_FATAL("NULL", _condition, __VA_ARGS__)
+
+#    define RHI_CONDITION_WARN_RETURN(_condition, _returning, ...)                                \
+        CONTEXT_CONDITION_WARN_RETURN("NULL", _condition, _returning, __VA_ARGS__)
+#    define RHI_CONDITION_ERROR_RETURN(_condition, _returning, ...)                               \
+        CONTEXT_CONDITION_ERROR_RETURN("NULL", _condition, _returning, __VA_ARGS__)
 #endif
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
 #include <fmt/format.h>
+#include <mutex>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <vector>
 
 struct ConsoleMessage {
@@ -202,15 +246,137 @@ struct ConsoleMessage {
     };
 
     int Line = -1;
-    std::string Message;
+    std::string_view Message;
     const char* File      = nullptr;
     const char* Function  = nullptr;
     const char* Context   = nullptr;
     Severity SeverityFlag = ConsoleMessage::Invalid;
+    uint32_t FiberId      = 0; // Job system fiber the message was logged from, 0 if none
 
     static const char* SeverityFlagToCString(ConsoleMessage::Severity code);
 };
 
+using ConsoleContextId = uint16_t;
+
+// Interned `_context` strings from the CONTEXT_* and RHI_* macros. Id 0 is reserved for messages
+// without a context. Zero initialised so call sites can intern before Console::Initialize
+struct ConsoleContextTable {
+    static constexpr size_t Capacity = 64;
+
+    std::array<const char*, Capacity> Names;
+    std::array<std::atomic<uint32_t>, Capacity> FilterFlags; // Severities suppressed per context
+    std::atomic<uint32_t> Count {1};
+    std::mutex Mutex;
+};
+
+struct ConsoleRecord;
+using ConsoleRecordFormatter = void (*)(const ConsoleRecord& record, fmt::memory_buffer& out);
+
+// Compact, trivially copyable log entry. The format string is kept by pointer (the macros only
+// ever pass literals) and the arguments are packed into Args, so formatting can be deferred to
+// whichever thread ends up writing the message
+struct ConsoleRecord {
+    static constexpr size_t ArgStorageSize = 184;
+
+    int Line                              = -1;
+    ConsoleMessage::Severity SeverityFlag = ConsoleMessage::Invalid;
+    const char* File                      = nullptr;
+    const char* Function                  = nullptr;
+    const char* Context                   = nullptr;
+    const char* Condition                 = nullptr;
+    const char* Format                    = nullptr;
+    uint32_t FormatSize                   = 0;
+    uint16_t ArgsSize                     = 0;
+    ConsoleContextId ContextId            = 0;
+    uint32_t FiberId                      = 0;
+    ConsoleRecordFormatter Formatter      = nullptr;
+    alignas(8) unsigned char Args[ArgStorageSize];
+};
+
+// Strings inside ConsoleRecord::Args are stored as [uint32_t size][chars]
+struct ConsoleRecordText {
+    static inline bool Write(unsigned char*& pos, const unsigned char* end, std::string_view text)
+    {
+        if ((size_t)(end - pos) < sizeof(uint32_t) + text.size()) {
+            return false;
+        }
+        uint32_t size = (uint32_t)text.size();
+        std::memcpy(pos, &size, sizeof(uint32_t));
+        std::memcpy(pos + sizeof(uint32_t), text.data(), text.size());
+        pos += sizeof(uint32_t) + text.size();
+        return true;
+    }
+
+    static inline std::string_view Read(const unsigned char*& pos)
+    {
+        uint32_t size;
+        std::memcpy(&size, pos, sizeof(uint32_t));
+        std::string_view text((const char*)pos + sizeof(uint32_t), size);
+        pos += sizeof(uint32_t) + size;
+        return text;
+    }
+};
+
+// Packs a single argument into ConsoleRecord::Args and reads it back as View on the formatting
+// side. Arithmetic, enum and pointer values are copied as is and strings are copied inline. Other
+// types are not captured, messages using them are formatted on the calling thread instead so the
+// argument's format spec still applies
+template <typename T, typename = void>
+struct ConsoleRecordArg {
+    static constexpr bool Captured = false;
+};
+
+template <typename T>
+struct ConsoleRecordArg<
+    T, std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T> ||
+                        (std::is_pointer_v<T> &&
+                         !std::is_same_v<std::remove_cv_t<std::remove_pointer_t<T>>, char>)>> {
+    using View                     = T;
+    static constexpr bool Captured = true;
+
+    static bool Write(unsigned char*& pos, const unsigned char* end, const T& value)
+    {
+        if ((size_t)(end - pos) < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(pos, &value, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    static View Read(const unsigned char*& pos)
+    {
+        T value;
+        std::memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+};
+
+template <typename T>
+struct ConsoleRecordArg<
+    T, std::enable_if_t<(std::is_pointer_v<T> &&
+                         std::is_same_v<std::remove_cv_t<std::remove_pointer_t<T>>, char>) ||
+                        std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view> ||
+                        std::is_same_v<T, fmt::string_view>>> {
+    using View                     = std::string_view;
+    static constexpr bool Captured = true;
+
+    static bool Write(unsigned char*& pos, const unsigned char* end, const T& value)
+    {
+        if constexpr (std::is_pointer_v<T>) {
+            std::string_view text = value != nullptr ? std::string_view(value) : "(null)";
+            return ConsoleRecordText::Write(pos, end, text);
+        }
+        else {
+            std::string_view text(value.data(), value.size());
+            return ConsoleRecordText::Write(pos, end, text);
+        }
+    }
+
+    static View Read(const unsigned char*& pos) { return ConsoleRecordText::Read(pos); }
+};
+
 enum ConsoleOutputFlags : uint32_t {
     ConsoleOutput_NoneBit             = 0,
     ConsoleOutput_FlushPerMessageBit  = 1 << 0,
@@ -225,6 +391,7 @@ enum ConsoleOutputFlags : uint32_t {
 struct ConsoleOutput {
     uint32_t Flags = ConsoleOutput_FlushPerMessageBit | ConsoleOutput_ColorBit |
                      ConsoleOutput_BreakAfterInfoBit | ConsoleOutput_BreakAfterHeaderBit;
+    fmt::memory_buffer Buffer; // Reused for every message so formatting doesn't allocate
 
     virtual ~ConsoleOutput() {}
 
@@ -234,8 +401,13 @@ struct ConsoleOutput {
     virtual std::string_view Name() const               = 0;
     virtual void PrintOutput(const ConsoleMessage& msg) = 0;
 
-    virtual std::string _FormatHead(const ConsoleMessage& msg);
-    virtual std::string _FormatBody(const ConsoleMessage& msg);
+    // Called by the sink thread in async mode, outputs that can amortise I/O across a batch
+    // (single flush, single write) should override this
+    virtual void PrintOutputBatch(const ConsoleMessage* msgs, size_t count);
+
+    // Both append to `out`, a single message is `_FormatHead` followed by `_FormatBody`
+    virtual void _FormatHead(const ConsoleMessage& msg, fmt::memory_buffer& out);
+    virtual void _FormatBody(const ConsoleMessage& msg, fmt::memory_buffer& out);
 };
 
 struct ConsoleTerminalOutput : public ConsoleOutput {
@@ -244,20 +416,110 @@ struct ConsoleTerminalOutput : public ConsoleOutput {
 
     inline std::string_view Name() const override { return "Error Terminal Output"; }
     void PrintOutput(const ConsoleMessage& msg) override;
+    void PrintOutputBatch(const ConsoleMessage* msgs, size_t count) override;
+
+private:
+    void _Write(const ConsoleMessage& msg);
+};
+
+enum ConsoleFlags : uint32_t {
+    Console_NoneBit  = 0,
+    Console_AsyncBit = 1 << 0,
+};
+
+enum ConsoleOverflowPolicy {
+    ConsoleOverflowPolicy_Block,
+    ConsoleOverflowPolicy_DropNewest,
+    ConsoleOverflowPolicy_DropOldest,
+};
+
+// Bounded lock-free queue (Vyukov) used to hand messages from the logging threads to the sink
+// thread. Each slot carries a sequence number so producers only ever contend on EnqueuePos and
+// the consumer never takes a lock. Producers may also pop to implement drop-oldest.
+struct ConsoleRingBuffer {
+    struct Slot {
+        std::atomic<size_t> Sequence;
+        ConsoleRecord Record;
+    };
+
+    Slot* Slots = nullptr;
+    size_t Mask = 0;
+    alignas(64) std::atomic<size_t> EnqueuePos {0};
+    alignas(64) std::atomic<size_t> DequeuePos {0};
+
+    void Initialize(size_t capacity);
+    void Destroy();
+
+    bool TryPush(const ConsoleRecord& record);
+    bool TryPop(ConsoleRecord& record);
+    inline size_t Capacity() const { return Mask + 1; }
+    inline bool Empty() const { return EnqueuePos.load() == DequeuePos.load(); }
 };
 
 struct Console {
+    static constexpr size_t DefaultQueueCapacity = 4096;
+    static constexpr size_t SinkBatchSize        = 64;
+
+    static inline Console* InstancePtr = nullptr;
+    static inline ConsoleContextTable Contexts;
+
     std::vector<ConsoleOutput*> Outputs;
     uint32_t SeverityFlags = ConsoleMessage::Info | ConsoleMessage::Warning |
                              ConsoleMessage::Error | ConsoleMessage::Fatal;
+    uint32_t Flags                       = Console_NoneBit;
+    ConsoleOverflowPolicy OverflowPolicy = ConsoleOverflowPolicy_Block;
+
+    // Async state, only used with Console_AsyncBit
+    ConsoleRingBuffer Queue;
+    std::thread SinkThread;
+    std::mutex OutputMutex;
+    std::mutex SinkMutex;
+    std::condition_variable SinkSignal;
+    std::atomic<bool> SinkRunning {false};
+    std::atomic<bool> SinkSleeping {false};
+    std::atomic<uint32_t> ActiveProducers {0}; // Threads inside _Submit, Destroy waits on them
+    std::atomic<uint64_t> SubmittedCount {0};
+    std::atomic<uint64_t> ConsumedCount {0};
+    std::atomic<uint64_t> DroppedCount {0};
+    std::atomic<uint64_t> BlockedCount {0};
+
+    static inline bool Enabled(ConsoleContextId context_id, ConsoleMessage::Severity severity)
+    {
+        return InstancePtr != nullptr && (InstancePtr->SeverityFlags & severity) &&
+               !(Contexts.FilterFlags[context_id].load(std::memory_order_relaxed) & severity);
+    }
+
+    // Returns the id for the context name, registering it on first use. Names are compared by
+    // content, so "OPENGL" from different translation units map to the same id
+    static ConsoleContextId InternContext(const char* context);
+    static const char* ContextName(ConsoleContextId context_id);
+
+    // Suppresses the given severities for a single context, on top of SeverityFlags
+    static void SetContextFilter(const char* context, uint32_t suppressed_severity_flags);
 
-    static void PrintToOutputs(int line, const std::string& msg, const char* file,
-                               const char* function, const char* context,
-                               ConsoleMessage::Severity severity);
+    // Checks the severity before touching any of the arguments, then captures them into a
+    // ConsoleRecord without formatting. Formatting happens on the sink thread in async mode
+    template <typename... TArgs>
+    static void Log(int line, const char* file, const char* function, const char* context,
+                    ConsoleContextId context_id, const char* condition,
+                    ConsoleMessage::Severity severity, fmt::format_string<TArgs...> format,
+                    TArgs&&... args);
 
-    void Initialize(int severity_flags = -1);
+    // Set by the job system whenever a worker switches fibers, tags messages with the fiber
+    static void SetFiberId(uint32_t fiber_id);
+    static uint32_t CurrentFiberId();
+
+    static void PrintToOutputs(const ConsoleRecord& record);
+    static void FormatRecord(const ConsoleRecord& record, fmt::memory_buffer& out);
+
+    void Initialize(int severity_flags = -1, uint32_t flags = Console_NoneBit,
+                    ConsoleOverflowPolicy policy = ConsoleOverflowPolicy_Block,
+                    size_t queue_capacity = DefaultQueueCapacity);
     void Destroy();
 
+    // Blocks until every message submitted before the call has been written by the sink
+    void Flush();
+
     void AddOutput(ConsoleOutput* output, uint32_t flags = ConsoleOutput_NoneBit);
 
     template <typename TConsoleOutput>
@@ -265,4 +527,71 @@ struct Console {
     {
         AddOutput(new TConsoleOutput, flags);
     }
+
+private:
+    template <typename... TArgs>
+    static void _FormatArgs(const ConsoleRecord& record, fmt::memory_buffer& out);
+    static void _FormatText(const ConsoleRecord& record, fmt::memory_buffer& out);
+    static void _PrintFormatted(ConsoleRecord& record, fmt::string_view format,
+                                fmt::format_args args);
+
+    // Returns false once the sink has stopped, the caller then writes the record itself
+    bool _Submit(const ConsoleRecord& record);
+    void _WriteNow(const ConsoleRecord& record);
+    void _WriteMessage(const ConsoleMessage& message);
+    void _WriteToOutputs(const ConsoleMessage* msgs, size_t count);
+    void _SinkMain();
 };
+
+template <typename... TArgs>
+void Console::Log(int line, const char* file, const char* function, const char* context,
+                  ConsoleContextId context_id, const char* condition,
+                  ConsoleMessage::Severity severity, fmt::format_string<TArgs...> format,
+                  TArgs&&... args)
+{
+    if (!Enabled(context_id, severity)) {
+        return;
+    }
+
+    fmt::string_view format_str = format.get();
+    ConsoleRecord record;
+    record.Line         = line;
+    record.SeverityFlag = severity;
+    record.File         = file;
+    record.Function     = function;
+    record.Context      = context;
+    record.ContextId    = context_id;
+    record.Condition    = condition;
+    record.FiberId      = CurrentFiberId();
+    record.Format       = format_str.data();
+    record.FormatSize   = (uint32_t)format_str.size();
+
+    if constexpr ((ConsoleRecordArg<std::decay_t<TArgs>>::Captured && ...)) {
+        unsigned char* pos                        = record.Args;
+        [[maybe_unused]] const unsigned char* end = record.Args + ConsoleRecord::ArgStorageSize;
+        if ((ConsoleRecordArg<std::decay_t<TArgs>>::Write(pos, end, args) && ...)) {
+            record.ArgsSize  = (uint16_t)(pos - record.Args);
+            record.Formatter = &Console::_FormatArgs<std::decay_t<TArgs>...>;
+            PrintToOutputs(record);
+            return;
+        }
+    }
+
+    // Custom types, or arguments too large to capture, are formatted now. The text is never cut,
+    // messages that don't fit a record are written on this thread
+    _PrintFormatted(record, format_str, fmt::make_format_args(args...));
+}
+
+template <typename... TArgs>
+void Console::_FormatArgs(const ConsoleRecord& record, fmt::memory_buffer& out)
+{
+    [[maybe_unused]] const unsigned char* pos = record.Args;
+    std::tuple<typename ConsoleRecordArg<TArgs>::View...> values {
+        ConsoleRecordArg<TArgs>::Read(pos)...};
+    std::apply(
+        [&](auto&... value) {
+            fmt::vformat_to(fmt::appender(out), fmt::string_view(record.Format, record.FormatSize),
+                            fmt::make_format_args(value...));
+        },
+        values);
+}
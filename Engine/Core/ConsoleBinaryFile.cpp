@@ -0,0 +1,307 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Core/ConsoleBinaryFile.h"
+#include <cstdio>
+
+#ifdef _WIN32
+#    define WIN32_LEAN_AND_MEAN
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <unistd.h>
+#endif
+
+static constexpr size_t AlignEntry(size_t size)
+{
+    return (size + 3) & ~(size_t)3;
+}
+
+ConsoleBinaryFileOutput::ConsoleBinaryFileOutput(std::string_view base_path, size_t file_size,
+                                                 uint32_t max_files)
+      : BasePath(base_path), FileSize(file_size), MaxFiles(max_files)
+{
+}
+
+void ConsoleBinaryFileOutput::Initialize(uint32_t flags)
+{
+    // Colour codes have no meaning in the file, the decoder decides whether to colour
+    Flags &= ~ConsoleOutput_ColorBit;
+    if (flags != ConsoleOutput_NoneBit) {
+        Flags = flags;
+    }
+    _Open();
+}
+
+void ConsoleBinaryFileOutput::Destroy()
+{
+    _Close();
+}
+
+void ConsoleBinaryFileOutput::PrintOutput(const ConsoleMessage& msg)
+{
+    if (Mapping == nullptr) {
+        return;
+    }
+
+    size_t message_size = msg.Message.size();
+    if (Used + _RequiredSize(msg, message_size) > FileSize) {
+        _Close();
+        if (!_Open()) {
+            return;
+        }
+        size_t needed = _RequiredSize(msg, message_size);
+        if (Used + needed > FileSize) {
+            // Larger than an entire file, keep what fits. Entries are padded to 4 bytes, so the
+            // first cut can still leave the entry up to 3 bytes over
+            message_size -= std::min(message_size, Used + needed - FileSize);
+            while (message_size > 0 && Used + _RequiredSize(msg, message_size) > FileSize) {
+                message_size--;
+            }
+            if (Used + _RequiredSize(msg, message_size) > FileSize) {
+                return;
+            }
+        }
+    }
+
+    ConsoleBinaryMessageEntry entry;
+    entry.FileId     = _WriteString(msg.File);
+    entry.FunctionId = _WriteString(msg.Function);
+    entry.ContextId  = _WriteString(msg.Context);
+    entry.Line       = msg.Line;
+    entry.FiberId    = msg.FiberId;
+    entry.Size       = (uint32_t)message_size;
+
+    entry.Entry.Kind     = ConsoleBinaryEntry_Message;
+    entry.Entry.Severity = (uint16_t)msg.SeverityFlag;
+    entry.Entry.Size     = (uint32_t)AlignEntry(sizeof(ConsoleBinaryMessageEntry) + message_size);
+
+    std::memcpy(Mapping + Used, &entry, sizeof(ConsoleBinaryMessageEntry));
+    std::memcpy(Mapping + Used + sizeof(ConsoleBinaryMessageEntry), msg.Message.data(),
+                message_size);
+    Used += entry.Entry.Size;
+    ((ConsoleBinaryFileHeader*)Mapping)->UsedSize = Used;
+}
+
+bool ConsoleBinaryFileOutput::_Open()
+{
+    std::string path = fmt::format("{}.{}.kylog", BasePath, Sequence % MaxFiles);
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+                              nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        fmt::println(stderr, "Failed to create console log file {}", path);
+        return false;
+    }
+    HANDLE map    = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+                                       (DWORD)((uint64_t)FileSize >> 32),
+                                       (DWORD)(FileSize & 0xffffffff), nullptr);
+    void* mapping = map != nullptr ? MapViewOfFile(map, FILE_MAP_WRITE, 0, 0, FileSize) : nullptr;
+    if (mapping == nullptr) {
+        fmt::println(stderr, "Failed to map console log file {}", path);
+        if (map != nullptr) {
+            CloseHandle(map);
+        }
+        CloseHandle(file);
+        return false;
+    }
+    FileHandle = (intptr_t)file;
+    MapHandle  = (intptr_t)map;
+#else
+    int file = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file < 0) {
+        fmt::println(stderr, "Failed to create console log file {}", path);
+        return false;
+    }
+    void* mapping = MAP_FAILED;
+    if (ftruncate(file, (off_t)FileSize) == 0) {
+        mapping = mmap(nullptr, FileSize, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    }
+    if (mapping == MAP_FAILED) {
+        fmt::println(stderr, "Failed to map console log file {}", path);
+        close(file);
+        return false;
+    }
+    FileHandle = file;
+#endif
+
+    Mapping = (unsigned char*)mapping;
+    Used    = sizeof(ConsoleBinaryFileHeader);
+    StringIds.clear();
+
+    ConsoleBinaryFileHeader header;
+    header.OutputFlags = Flags;
+    header.Sequence    = Sequence++;
+    header.UsedSize    = Used;
+    std::memcpy(Mapping, &header, sizeof(ConsoleBinaryFileHeader));
+    return true;
+}
+
+void ConsoleBinaryFileOutput::_Close()
+{
+    if (Mapping == nullptr) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(Mapping);
+    CloseHandle((HANDLE)MapHandle);
+    LARGE_INTEGER size;
+    size.QuadPart = (LONGLONG)Used;
+    SetFilePointerEx((HANDLE)FileHandle, size, nullptr, FILE_BEGIN);
+    SetEndOfFile((HANDLE)FileHandle);
+    CloseHandle((HANDLE)FileHandle);
+    MapHandle = 0;
+#else
+    munmap(Mapping, FileSize);
+    if (ftruncate((int)FileHandle, (off_t)Used) != 0) {
+        fmt::println(stderr, "Failed to trim console log file");
+    }
+    close((int)FileHandle);
+#endif
+
+    Mapping    = nullptr;
+    FileHandle = -1;
+}
+
+size_t ConsoleBinaryFileOutput::_RequiredSize(const ConsoleMessage& msg,
+                                              size_t message_size) const
+{
+    return AlignEntry(sizeof(ConsoleBinaryMessageEntry) + message_size) +
+           _StringEntrySize(msg.File) + _StringEntrySize(msg.Function) +
+           _StringEntrySize(msg.Context);
+}
+
+size_t ConsoleBinaryFileOutput::_StringEntrySize(const char* str) const
+{
+    if (str == nullptr || StringIds.find(str) != StringIds.end()) {
+        return 0;
+    }
+    return AlignEntry(sizeof(ConsoleBinaryStringEntry) + std::strlen(str) + 1);
+}
+
+uint32_t ConsoleBinaryFileOutput::_WriteString(const char* str)
+{
+    if (str == nullptr) {
+        return ConsoleBinaryEntry::NoString;
+    }
+    auto it = StringIds.find(str);
+    if (it != StringIds.end()) {
+        return it->second;
+    }
+
+    ConsoleBinaryStringEntry entry;
+    entry.Id         = (uint32_t)StringIds.size();
+    entry.Size       = (uint32_t)std::strlen(str);
+    entry.Entry.Kind = ConsoleBinaryEntry_String;
+    entry.Entry.Size = (uint32_t)AlignEntry(sizeof(ConsoleBinaryStringEntry) + entry.Size + 1);
+
+    std::memcpy(Mapping + Used, &entry, sizeof(ConsoleBinaryStringEntry));
+    std::memcpy(Mapping + Used + sizeof(ConsoleBinaryStringEntry), str, entry.Size + 1);
+    Used += entry.Entry.Size;
+    StringIds.emplace(str, entry.Id);
+    return entry.Id;
+}
+
+bool ConsoleBinaryFileReader::Open(const char* path)
+{
+    FILE* file = std::fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    Data.resize(size > 0 ? (size_t)size : 0);
+    size_t read = std::fread(Data.data(), 1, Data.size(), file);
+    std::fclose(file);
+
+    ConsoleBinaryFileHeader expected;
+    if (read < sizeof(ConsoleBinaryFileHeader)) {
+        return false;
+    }
+    std::memcpy(&Header, Data.data(), sizeof(ConsoleBinaryFileHeader));
+    if (std::memcmp(Header.Magic, expected.Magic, sizeof(expected.Magic)) != 0 ||
+        Header.Version != ConsoleBinaryFileHeader::CurrentVersion) {
+        return false;
+    }
+    if (Header.UsedSize > read) {
+        Header.UsedSize = read;
+    }
+    Offset = sizeof(ConsoleBinaryFileHeader);
+    Strings.clear();
+    return true;
+}
+
+bool ConsoleBinaryFileReader::Next(ConsoleMessage& msg)
+{
+    while (Offset + sizeof(ConsoleBinaryEntry) <= Header.UsedSize) {
+        ConsoleBinaryEntry entry;
+        std::memcpy(&entry, Data.data() + Offset, sizeof(ConsoleBinaryEntry));
+        if (entry.Size < sizeof(ConsoleBinaryEntry) || Offset + entry.Size > Header.UsedSize) {
+            return false;
+        }
+        const unsigned char* body = Data.data() + Offset;
+        Offset += entry.Size;
+
+        // Corrupt or truncated entries end the log instead of reading past them
+        if (entry.Kind == ConsoleBinaryEntry_String) {
+            ConsoleBinaryStringEntry str;
+            if (entry.Size < sizeof(ConsoleBinaryStringEntry)) {
+                return false;
+            }
+            std::memcpy(&str, body, sizeof(ConsoleBinaryStringEntry));
+            if (sizeof(ConsoleBinaryStringEntry) + (uint64_t)str.Size + 1 > entry.Size ||
+                body[sizeof(ConsoleBinaryStringEntry) + str.Size] != '\0' ||
+                str.Id > Strings.size()) {
+                return false;
+            }
+            if (str.Id >= Strings.size()) {
+                Strings.resize(str.Id + 1);
+            }
+            Strings[str.Id] =
+                std::string_view((const char*)body + sizeof(ConsoleBinaryStringEntry), str.Size);
+        }
+        else if (entry.Kind == ConsoleBinaryEntry_Message) {
+            ConsoleBinaryMessageEntry message;
+            if (entry.Size < sizeof(ConsoleBinaryMessageEntry)) {
+                return false;
+            }
+            std::memcpy(&message, body, sizeof(ConsoleBinaryMessageEntry));
+            if (sizeof(ConsoleBinaryMessageEntry) + (uint64_t)message.Size > entry.Size) {
+                return false;
+            }
+
+            auto string_at = [this](uint32_t id) -> const char* {
+                if (id >= Strings.size()) {
+                    return nullptr;
+                }
+                return Strings[id].data();
+            };
+            msg.Line    = message.Line;
+            msg.Message = std::string_view((const char*)body + sizeof(ConsoleBinaryMessageEntry),
+                                           message.Size);
+            msg.File         = string_at(message.FileId);
+            msg.Function     = string_at(message.FunctionId);
+            msg.Context      = string_at(message.ContextId);
+            msg.SeverityFlag = (ConsoleMessage::Severity)entry.Severity;
+            msg.FiberId      = message.FiberId;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,108 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "Core/Console.h"
+#include <string>
+#include <unordered_map>
+
+enum ConsoleBinaryEntryKind : uint16_t {
+    ConsoleBinaryEntry_String  = 1,
+    ConsoleBinaryEntry_Message = 2,
+};
+
+struct ConsoleBinaryFileHeader {
+    static constexpr uint32_t CurrentVersion = 2;
+
+    char Magic[8]        = {'K', 'R', 'Y', 'O', 'S', 'L', 'O', 'G'};
+    uint32_t Version     = CurrentVersion;
+    uint32_t OutputFlags = ConsoleOutput_NoneBit;
+    uint64_t Sequence    = 0;
+    uint64_t UsedSize    = 0; // Bytes written including this header, updated after every entry
+};
+
+// Every entry is 4 byte aligned and starts with this. File, function and context strings are
+// written once per file as String entries and referenced by id from Message entries
+struct ConsoleBinaryEntry {
+    static constexpr uint32_t NoString = UINT32_MAX;
+
+    uint16_t Kind     = 0;
+    uint16_t Severity = 0;
+    uint32_t Size     = 0; // Including this header and padding
+};
+
+// Followed by the null terminated string
+struct ConsoleBinaryStringEntry {
+    ConsoleBinaryEntry Entry;
+    uint32_t Id   = 0;
+    uint32_t Size = 0; // Excluding the terminator
+};
+
+// Followed by the formatted message text
+struct ConsoleBinaryMessageEntry {
+    ConsoleBinaryEntry Entry;
+    int32_t Line        = -1;
+    uint32_t FileId     = ConsoleBinaryEntry::NoString;
+    uint32_t FunctionId = ConsoleBinaryEntry::NoString;
+    uint32_t ContextId  = ConsoleBinaryEntry::NoString;
+    uint32_t FiberId    = 0;
+    uint32_t Size       = 0;
+};
+
+// Writes messages into a memory mapped file, rotating through MaxFiles files named
+// `<BasePath>.<index>.kylog` once one fills up. Writing is a memcpy into the mapping, the only
+// syscalls happen on rotation. Decode with KryosLogDecoder
+struct ConsoleBinaryFileOutput : public ConsoleOutput {
+    static constexpr size_t DefaultFileSize = 16 * 1024 * 1024;
+
+    std::string BasePath;
+    size_t FileSize   = DefaultFileSize;
+    uint32_t MaxFiles = 4;
+
+    unsigned char* Mapping = nullptr;
+    size_t Used            = 0;
+    uint64_t Sequence      = 0;
+    intptr_t FileHandle    = -1;
+    intptr_t MapHandle     = 0;
+    std::unordered_map<const char*, uint32_t> StringIds;
+
+    ConsoleBinaryFileOutput(std::string_view base_path = "Kryos",
+                            size_t file_size = DefaultFileSize, uint32_t max_files = 4);
+
+    void Initialize(uint32_t flags = ConsoleOutput_NoneBit) override;
+    void Destroy() override;
+
+    inline std::string_view Name() const override { return "Binary File Output"; }
+    void PrintOutput(const ConsoleMessage& msg) override;
+
+private:
+    bool _Open();
+    void _Close();
+    size_t _RequiredSize(const ConsoleMessage& msg, size_t message_size) const;
+    size_t _StringEntrySize(const char* str) const;
+    uint32_t _WriteString(const char* str);
+};
+
+// Reads files written by ConsoleBinaryFileOutput back into ConsoleMessages
+struct ConsoleBinaryFileReader {
+    ConsoleBinaryFileHeader Header;
+    std::vector<unsigned char> Data;
+    std::vector<std::string_view> Strings;
+    size_t Offset = 0;
+
+    bool Open(const char* path);
+    bool Next(ConsoleMessage& msg);
+};
@@ -0,0 +1,104 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Core/Fiber.h"
+#include "Core/Console.h"
+
+#ifdef _WIN32
+#    define WIN32_LEAN_AND_MEAN
+#    include <windows.h>
+
+static void WINAPI FiberEntry(void* data)
+{
+    Fiber* fiber = (Fiber*)data;
+    fiber->Function(fiber->Data);
+}
+
+void Fiber::Initialize(FiberFunction function, void* data, size_t stack_size)
+{
+    Function  = function;
+    Data      = data;
+    StackSize = stack_size;
+    Handle    = CreateFiber(stack_size, &FiberEntry, this);
+    CONTEXT_CONDITION_FATAL("FIBER", Handle != nullptr, "Failed to create fiber");
+}
+
+void Fiber::InitializeFromThread()
+{
+    Handle = ConvertThreadToFiber(this);
+    CONTEXT_CONDITION_FATAL("FIBER", Handle != nullptr, "Failed to convert thread to fiber");
+}
+
+void Fiber::Destroy()
+{
+    if (Function != nullptr) {
+        DeleteFiber(Handle);
+    }
+    else {
+        ConvertFiberToThread();
+    }
+    Handle = nullptr;
+}
+
+void Fiber::SwitchTo(Fiber& target)
+{
+    SwitchToFiber(target.Handle);
+}
+
+#else
+#    include <cstdlib>
+
+// makecontext only forwards int arguments, so the pointer is split in two
+static void FiberEntry(uint32_t low, uint32_t high)
+{
+    Fiber* fiber = (Fiber*)(((uintptr_t)high << 32) | (uintptr_t)low);
+    fiber->Function(fiber->Data);
+}
+
+void Fiber::Initialize(FiberFunction function, void* data, size_t stack_size)
+{
+    Function  = function;
+    Data      = data;
+    StackSize = stack_size;
+    Stack     = std::malloc(stack_size);
+    CONTEXT_CONDITION_FATAL("FIBER", Stack != nullptr, "Failed to allocate fiber stack");
+
+    getcontext(&Context);
+    Context.uc_stack.ss_sp   = Stack;
+    Context.uc_stack.ss_size = stack_size;
+    Context.uc_link          = nullptr;
+
+    uintptr_t self = (uintptr_t)this;
+    makecontext(&Context, (void (*)())&FiberEntry, 2, (uint32_t)(self & 0xffffffff),
+                (uint32_t)(self >> 32));
+}
+
+void Fiber::InitializeFromThread()
+{
+    getcontext(&Context);
+}
+
+void Fiber::Destroy()
+{
+    std::free(Stack);
+    Stack = nullptr;
+}
+
+void Fiber::SwitchTo(Fiber& target)
+{
+    swapcontext(&Context, &target.Context);
+}
+
+#endif
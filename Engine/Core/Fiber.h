@@ -0,0 +1,52 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef _WIN32
+#    include <ucontext.h>
+#endif
+
+using FiberFunction = void (*)(void* data);
+
+// User mode execution context with its own stack. Switching is cooperative, a fiber runs until
+// it calls SwitchTo. Uses ucontext on POSIX and the native fiber API on Windows
+struct Fiber {
+    static constexpr size_t DefaultStackSize = 64 * 1024;
+
+    uint32_t Id            = 0;
+    FiberFunction Function = nullptr;
+    void* Data             = nullptr;
+    void* Stack            = nullptr;
+    size_t StackSize       = 0;
+    Fiber* Next            = nullptr; // Free for schedulers to link suspended fibers
+#ifdef _WIN32
+    void* Handle = nullptr;
+#else
+    ucontext_t Context;
+#endif
+
+    void Initialize(FiberFunction function, void* data, size_t stack_size = DefaultStackSize);
+
+    // Wraps the calling thread so it can be switched away from and back to
+    void InitializeFromThread();
+    void Destroy();
+
+    // Saves the current context into this fiber and resumes target
+    void SwitchTo(Fiber& target);
+};
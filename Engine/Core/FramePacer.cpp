@@ -0,0 +1,91 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Core/FramePacer.h"
+#include "Core/Profiler.h"
+#include "Core/Time.h"
+#include <chrono>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#    include <immintrin.h>
+#    define KRYOS_SPIN_PAUSE() _mm_pause()
+#else
+#    define KRYOS_SPIN_PAUSE() std::this_thread::yield()
+#endif
+
+void FramePacer::Initialize(double target_fps, double idle_fps)
+{
+    IdleFps = idle_fps;
+    SetTargetFps(target_fps);
+}
+
+void FramePacer::SetTargetFps(double target_fps)
+{
+    TargetFps   = target_fps;
+    FramePeriod = target_fps > 0.0 ? (uint64_t)(1e9 / target_fps) : 0;
+    Reset();
+}
+
+void FramePacer::Wait()
+{
+    SleepNanoseconds = 0;
+    SpinNanoseconds  = 0;
+    if (FramePeriod == 0) {
+        return;
+    }
+
+    PROFILE_SCOPE("FramePacer::Wait");
+    uint64_t now = Time::NowNanoseconds();
+
+    // Sleep while the deadline is further away than the scheduler might oversleep by, and learn
+    // the actual oversleep so the spin window tracks the platform's timer resolution
+    uint64_t spin_window = SleepOvershoot + MinSpinDuration;
+    if (now + spin_window < NextFrame) {
+        uint64_t sleep_duration = NextFrame - now - spin_window;
+        std::this_thread::sleep_for(std::chrono::nanoseconds(sleep_duration));
+
+        uint64_t woke      = Time::NowNanoseconds();
+        uint64_t slept     = woke - now;
+        uint64_t overshoot = slept > sleep_duration ? slept - sleep_duration : 0;
+        if (overshoot > SleepOvershoot) {
+            SleepOvershoot = overshoot;
+        }
+        else {
+            SleepOvershoot -= (SleepOvershoot - overshoot) / 16;
+        }
+        SleepNanoseconds = slept;
+        now              = woke;
+    }
+
+    uint64_t spin_start = now;
+    while (now < NextFrame) {
+        KRYOS_SPIN_PAUSE();
+        now = Time::NowNanoseconds();
+    }
+    SpinNanoseconds = now - spin_start;
+
+    // Keep a steady cadence, but drop the schedule when a frame ran long instead of rushing the
+    // following frames to make up for it
+    NextFrame += FramePeriod;
+    if (NextFrame < now) {
+        NextFrame = now + FramePeriod;
+    }
+}
+
+void FramePacer::Reset()
+{
+    NextFrame = Time::NowNanoseconds() + FramePeriod;
+}
@@ -0,0 +1,44 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+// Caps the frame rate by sleeping for the bulk of the remaining frame time and spinning for the
+// last stretch, where the OS scheduler is too coarse to wake up on time
+struct FramePacer {
+    double TargetFps = 0.0;  // 0 leaves the frame rate uncapped, e.g. when relying on vsync
+    double IdleFps   = 10.0; // Rate events are waited on while the window is unfocused
+
+    uint64_t FramePeriod      = 0;
+    uint64_t NextFrame        = 0;
+    uint64_t SleepOvershoot   = 1'000'000; // Running estimate of how late sleep_for wakes up
+    uint64_t MinSpinDuration  = 200'000;
+    uint64_t SleepNanoseconds = 0; // Time spent in the last Wait, for diagnostics
+    uint64_t SpinNanoseconds  = 0;
+
+    void Initialize(double target_fps = 0.0, double idle_fps = 10.0);
+    void SetTargetFps(double target_fps);
+
+    // Blocks until the next frame is due, returns immediately when uncapped
+    void Wait();
+
+    // Seconds to block in glfwWaitEventsTimeout while idle
+    inline double IdleTimeout() const { return IdleFps > 0.0 ? 1.0 / IdleFps : 0.0; }
+
+    // Restarts pacing from now, call after idling so the cap doesn't try to catch up
+    void Reset();
+};
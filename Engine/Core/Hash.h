@@ -0,0 +1,41 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// 64 bit FNV-1a, stable across runs and platforms so hashes can be persisted in cache files.
+// Chain calls by passing the previous result as seed
+constexpr uint64_t HashSeed = 0xcbf29ce484222325ull;
+
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t seed = HashSeed)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint64_t hash        = seed;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Includes the length so that consecutive strings hash differently to their concatenation
+inline uint64_t HashString(std::string_view str, uint64_t seed = HashSeed)
+{
+    uint64_t size = str.size();
+    return HashBytes(str.data(), str.size(), HashBytes(&size, sizeof(size), seed));
+}
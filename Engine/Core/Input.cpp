@@ -15,73 +15,327 @@
 
 #include "Core/Input.h"
 #include "Core/Console.h"
+#include "Core/Profiler.h"
+#include "Core/Time.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
 
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 
 static Input* s_InstancePtr = nullptr;
 
-#define KY_REG_ONCE_IMPL(func, input_type, code, pressed)                                         \
-    bool result = func(code);                                                                     \
-    if (result) {                                                                                 \
-        result = s_InstancePtr->_RegisterOnce(input_type, code, pressed);                         \
-    }                                                                                             \
-    return result
+// Recording file layout: InputRecordHeader, then per frame the delta time, event count and that
+// many InputRecordEvents, all little endian as written by the recording machine
+struct InputRecordHeader {
+    static constexpr char Magic[8]          = {'K', 'R', 'Y', 'O', 'S', 'I', 'N', 'P'};
+    static constexpr uint32_t CurrentVersion = 1;
 
-#define KY_REG_ONCE_WITH_HANDLE_IMPL(func, handle, input_type, code, pressed)                     \
-    bool result = func(handle, code);                                                             \
-    if (result) {                                                                                 \
-        result = s_InstancePtr->_RegisterOnce(input_type, code, pressed);                         \
-    }                                                                                             \
-    return result
+    char Identifier[8];
+    uint32_t Version;
+    float CursorX;
+    float CursorY;
+    float FramebufferWidth;
+    float FramebufferHeight;
+};
 
-void Input::Initialize(WindowHandle& window)
+struct InputRecordEvent {
+    uint8_t Type;
+    uint8_t Action;
+    uint16_t Mods;
+    int32_t Code;
+    float Value[2];
+    uint32_t TimeOffset; // Microseconds since the previous PollEvents
+};
+
+static glm::vec2 ApplyRadialDeadzone(glm::vec2 stick, const GamepadSettings& settings)
+{
+    float magnitude = glm::length(stick);
+    if (magnitude <= settings.InnerDeadzone) {
+        return glm::vec2(0.0f);
+    }
+
+    float range  = std::max(settings.OuterDeadzone - settings.InnerDeadzone, 1e-4f);
+    float scaled = std::min((magnitude - settings.InnerDeadzone) / range, 1.0f);
+    return stick / magnitude * std::pow(scaled, settings.ResponseExponent);
+}
+
+static float ApplyTriggerDeadzone(float trigger, const GamepadSettings& settings)
+{
+    // GLFW reports released triggers as -1
+    float value = (trigger + 1.0f) * 0.5f;
+    if (value <= settings.TriggerDeadzone) {
+        return 0.0f;
+    }
+
+    float range  = std::max(1.0f - settings.TriggerDeadzone, 1e-4f);
+    float scaled = std::min((value - settings.TriggerDeadzone) / range, 1.0f);
+    return std::pow(scaled, settings.ResponseExponent);
+}
+
+bool InputGlfwGamepadSource::ReadGamepad(GamepadJoystick joystick, GLFWgamepadstate& state)
 {
+    return glfwGetGamepadState(joystick, &state) == GLFW_TRUE;
+}
+
+void Input::Initialize(WindowHandle& window, uint32_t flags)
+{
+    Gamepads.fill(GamepadState {});
+    GamepadSamplesConnected.reset();
+    PendingEvents.clear();
     s_InstancePtr            = this;
     s_InstancePtr->WindowPtr = &window;
-    for (RegisteredInput& reg : s_InstancePtr->RegBuffer) {
-        reg.Type = InputType_Unknown;
+    s_InstancePtr->Flags     = flags;
+
+    KeyState.reset();
+    PrevKeyState.reset();
+    MouseState.reset();
+    PrevMouseState.reset();
+    EventCount        = 0;
+    DroppedEventCount = 0;
+
+    double x, y;
+    glfwGetCursorPos(window.WindowPtr, &x, &y);
+    Cursor      = glm::vec2((float)x, (float)y);
+    Scroll      = glm::vec2(0.0f);
+    Framebuffer = window.FramebufferSize();
+
+    glfwSetKeyCallback(window.WindowPtr, _KeyCallback);
+    glfwSetMouseButtonCallback(window.WindowPtr, _MouseButtonCallback);
+    glfwSetCursorPosCallback(window.WindowPtr, _CursorPosCallback);
+    glfwSetScrollCallback(window.WindowPtr, _ScrollCallback);
+    glfwSetCharCallback(window.WindowPtr, _CharCallback);
+    glfwSetFramebufferSizeCallback(window.WindowPtr, _FramebufferSizeCallback);
+    glfwSetWindowFocusCallback(window.WindowPtr, _FocusCallback);
+    Focused.store(window.Focused(), std::memory_order_relaxed);
+}
+
+bool Input::InitializeReplay(std::string_view path)
+{
+    Gamepads.fill(GamepadState {});
+    GamepadSamplesConnected.reset();
+    s_InstancePtr = this;
+    WindowPtr     = nullptr;
+    Flags         = Input_NoneBit;
+
+    KeyState.reset();
+    PrevKeyState.reset();
+    MouseState.reset();
+    PrevMouseState.reset();
+    EventCount        = 0;
+    DroppedEventCount = 0;
+    Scroll            = glm::vec2(0.0f);
+
+    ReplayFile = std::fopen(std::string(path).c_str(), "rb");
+    CONTEXT_CONDITION_ERROR_RETURN("INPUT", ReplayFile != nullptr, false,
+                                   "Failed to open input recording '{}'", path);
+
+    InputRecordHeader header;
+    bool valid = std::fread(&header, sizeof(header), 1, ReplayFile) == 1 &&
+                 std::equal(header.Identifier, header.Identifier + sizeof(header.Identifier),
+                            InputRecordHeader::Magic) &&
+                 header.Version == InputRecordHeader::CurrentVersion;
+    if (!valid) {
+        std::fclose(ReplayFile);
+        ReplayFile = nullptr;
+        CONTEXT_ERROR_RETURN("INPUT", false, "'{}' is not a supported input recording", path);
+    }
+
+    Cursor      = glm::vec2(header.CursorX, header.CursorY);
+    Framebuffer = glm::vec2(header.FramebufferWidth, header.FramebufferHeight);
+    _ReadReplayFrame();
+    CONTEXT_INFO("INPUT", "Replaying input recording '{}'", path);
+    return true;
+}
+
+void Input::Destroy()
+{
+    StopRecording();
+    if (ReplayFile != nullptr) {
+        std::fclose(ReplayFile);
+        ReplayFile        = nullptr;
+        ReplayFrameLoaded = false;
+        return;
+    }
+
+    CONTEXT_CONDITION_ERROR("INPUT", WindowPtr != nullptr && WindowPtr->Valid(),
+                            "Input window destroyed before input, cannot remove callbacks");
+    glfwSetKeyCallback(WindowPtr->WindowPtr, nullptr);
+    glfwSetMouseButtonCallback(WindowPtr->WindowPtr, nullptr);
+    glfwSetCursorPosCallback(WindowPtr->WindowPtr, nullptr);
+    glfwSetScrollCallback(WindowPtr->WindowPtr, nullptr);
+    glfwSetCharCallback(WindowPtr->WindowPtr, nullptr);
+    glfwSetFramebufferSizeCallback(WindowPtr->WindowPtr, nullptr);
+    glfwSetWindowFocusCallback(WindowPtr->WindowPtr, nullptr);
+    WindowPtr = nullptr;
+}
+
+bool Input::StartRecording(std::string_view path)
+{
+    CONTEXT_CONDITION_ERROR_RETURN("INPUT", !Replaying(), false,
+                                   "Cannot record input while replaying a recording");
+    StopRecording();
+
+    RecordFile = std::fopen(std::string(path).c_str(), "wb");
+    CONTEXT_CONDITION_ERROR_RETURN("INPUT", RecordFile != nullptr, false,
+                                   "Failed to open '{}' to record input", path);
+
+    InputRecordHeader header = {
+        .Identifier        = {},
+        .Version           = InputRecordHeader::CurrentVersion,
+        .CursorX           = Cursor.x,
+        .CursorY           = Cursor.y,
+        .FramebufferWidth  = Framebuffer.x,
+        .FramebufferHeight = Framebuffer.y,
+    };
+    std::copy_n(InputRecordHeader::Magic, sizeof(header.Identifier), header.Identifier);
+    std::fwrite(&header, sizeof(header), 1, RecordFile);
+
+    RecordEvents.clear();
+    RecordFrameTime = Time::NowNanoseconds();
+    CONTEXT_INFO("INPUT", "Recording input to '{}'", path);
+    return true;
+}
+
+void Input::StopRecording()
+{
+    if (RecordFile != nullptr) {
+        std::fclose(RecordFile);
+        RecordFile = nullptr;
     }
 }
 
 bool Input::KeyPressed(KeyCode code)
 {
-    KY_REG_ONCE_IMPL(KeyPress, InputType_Keyboard, code, true);
+    return code >= 0 && code <= KeyCode_Last && s_InstancePtr->KeyState[code] &&
+           !s_InstancePtr->PrevKeyState[code];
 }
 
 bool Input::KeyReleased(KeyCode code)
 {
-    KY_REG_ONCE_IMPL(KeyRelease, InputType_Keyboard, code, false);
+    return code >= 0 && code <= KeyCode_Last && !s_InstancePtr->KeyState[code] &&
+           s_InstancePtr->PrevKeyState[code];
 }
 
 bool Input::KeyPress(KeyCode code)
 {
-    return glfwGetKey(s_InstancePtr->WindowPtr->WindowPtr, code) == GLFW_PRESS;
+    return code >= 0 && code <= KeyCode_Last && s_InstancePtr->KeyState[code];
 }
 
 bool Input::KeyRelease(KeyCode code)
 {
-    return glfwGetKey(s_InstancePtr->WindowPtr->WindowPtr, code) == GLFW_RELEASE;
+    return code >= 0 && code <= KeyCode_Last && !s_InstancePtr->KeyState[code];
 }
 
 bool Input::MousePressed(MouseButton button)
 {
-    KY_REG_ONCE_IMPL(MousePress, InputType_Mouse, button, true);
+    return button >= 0 && button <= MouseButton_Last && s_InstancePtr->MouseState[button] &&
+           !s_InstancePtr->PrevMouseState[button];
 }
 
 bool Input::MouseReleased(MouseButton button)
 {
-    KY_REG_ONCE_IMPL(MouseRelease, InputType_Mouse, button, false);
+    return button >= 0 && button <= MouseButton_Last && !s_InstancePtr->MouseState[button] &&
+           s_InstancePtr->PrevMouseState[button];
 }
 
 bool Input::MousePress(MouseButton button)
 {
-    return glfwGetMouseButton(s_InstancePtr->WindowPtr->WindowPtr, button) == GLFW_PRESS;
+    return button >= 0 && button <= MouseButton_Last && s_InstancePtr->MouseState[button];
 }
 
 bool Input::MouseRelease(MouseButton button)
 {
-    return glfwGetMouseButton(s_InstancePtr->WindowPtr->WindowPtr, button) == GLFW_RELEASE;
+    return button >= 0 && button <= MouseButton_Last && !s_InstancePtr->MouseState[button];
+}
+
+glm::vec2 Input::MousePosition()
+{
+    return s_InstancePtr->Cursor;
+}
+
+glm::vec2 Input::MouseScroll()
+{
+    return s_InstancePtr->Scroll;
+}
+
+glm::vec2 Input::FramebufferSize()
+{
+    return s_InstancePtr->Framebuffer;
+}
+
+bool Input::WindowFocused()
+{
+    return s_InstancePtr->Focused.load(std::memory_order_relaxed);
+}
+
+bool Input::GamepadConnected(GamepadJoystick joystick)
+{
+    return joystick >= 0 && joystick <= GamepadJoystick_LAST &&
+           s_InstancePtr->Gamepads[joystick].Connected;
+}
+
+bool Input::GamepadButtonPressed(GamepadJoystick joystick, GamepadButton button)
+{
+    if (!GamepadConnected(joystick) || button < 0 || button > GamepadButton_Last) {
+        return false;
+    }
+    const GamepadState& gamepad = s_InstancePtr->Gamepads[joystick];
+    return gamepad.Buttons[button] && !gamepad.PrevButtons[button];
+}
+
+bool Input::GamepadButtonReleased(GamepadJoystick joystick, GamepadButton button)
+{
+    if (!GamepadConnected(joystick) || button < 0 || button > GamepadButton_Last) {
+        return false;
+    }
+    const GamepadState& gamepad = s_InstancePtr->Gamepads[joystick];
+    return !gamepad.Buttons[button] && gamepad.PrevButtons[button];
+}
+
+bool Input::GamepadButtonPress(GamepadJoystick joystick, GamepadButton button)
+{
+    return GamepadConnected(joystick) && button >= 0 && button <= GamepadButton_Last &&
+           s_InstancePtr->Gamepads[joystick].Buttons[button];
+}
+
+float Input::GamepadAxisValue(GamepadJoystick joystick, GamepadAxis axis)
+{
+    if (!GamepadConnected(joystick) || axis < 0 || axis > GamepadAxis_Last) {
+        return 0.0f;
+    }
+    return s_InstancePtr->Gamepads[joystick].Axes[axis];
+}
+
+glm::vec2 Input::GamepadStick(GamepadJoystick joystick, bool right)
+{
+    return right ? glm::vec2(GamepadAxisValue(joystick, GamepadAxis_RightX),
+                             GamepadAxisValue(joystick, GamepadAxis_RightY))
+                 : glm::vec2(GamepadAxisValue(joystick, GamepadAxis_LeftX),
+                             GamepadAxisValue(joystick, GamepadAxis_LeftY));
+}
+
+void Input::SetGamepadSource(InputGamepadSource* source)
+{
+    s_InstancePtr->GamepadSourcePtr = source;
+}
+
+InputEventView Input::FrameEvents()
+{
+    return InputEventView {s_InstancePtr->Events.data(), s_InstancePtr->EventCount};
+}
+
+void Input::AddActionMap(InputActionMap& map)
+{
+    map.Compile();
+    s_InstancePtr->ActionMaps.push_back(&map);
+}
+
+void Input::RemoveActionMap(InputActionMap& map)
+{
+    std::vector<InputActionMap*>& maps = s_InstancePtr->ActionMaps;
+    maps.erase(std::remove(maps.begin(), maps.end(), &map), maps.end());
 }
 
 std::string_view Input::TypeToString(InputType type)
@@ -112,55 +366,305 @@ std::string_view Input::MouseModeToString(MouseMode mode)
     }
 }
 
-void Input::PollEvents()
+void Input::PollEvents(double wait_timeout)
 {
-    glfwPollEvents();
-    size_t reg_counted = 0;
-    for (RegisteredInput& reg : s_InstancePtr->RegBuffer) {
-        if (reg_counted == s_InstancePtr->RegActiveCount) {
-            break;
+    PROFILE_SCOPE("Input::PollEvents");
+    s_InstancePtr->PrevKeyState   = s_InstancePtr->KeyState;
+    s_InstancePtr->PrevMouseState = s_InstancePtr->MouseState;
+    s_InstancePtr->EventCount     = 0;
+    s_InstancePtr->Scroll         = glm::vec2(0.0f);
+
+    if (s_InstancePtr->Replaying()) {
+        if (s_InstancePtr->ReplayFrameLoaded) {
+            for (const InputEvent& event : s_InstancePtr->ReplayEvents) {
+                s_InstancePtr->_ApplyEvent(event);
+            }
+            s_InstancePtr->_ReadReplayFrame();
         }
-        else if (reg.Type == InputType_Unknown) {
-            continue;
+        s_InstancePtr->_SampleGamepads();
+        s_InstancePtr->_UpdateGamepads();
+    }
+    else if (s_InstancePtr->Flags & Input_EventThreadBit) {
+        // Swap the pending events out so the event thread isn't held up while they're applied,
+        // each keeps the timestamp it was received with
+        {
+            std::lock_guard<std::mutex> lock(s_InstancePtr->PendingMutex);
+            std::swap(s_InstancePtr->PendingEvents, s_InstancePtr->DrainedEvents);
+            s_InstancePtr->_UpdateGamepads();
         }
-        reg_counted++;
-
-        if (!reg.RemoveNextTick) {
-            reg.RemoveNextTick = true;
+        for (const InputEvent& event : s_InstancePtr->DrainedEvents) {
+            s_InstancePtr->_ApplyEvent(event);
+        }
+        s_InstancePtr->DrainedEvents.clear();
+    }
+    else {
+        if (wait_timeout > 0.0) {
+            glfwWaitEventsTimeout(wait_timeout);
         }
         else {
-            reg.Type = InputType_Unknown;
-            s_InstancePtr->RegActiveCount--;
+            glfwPollEvents();
         }
+        s_InstancePtr->_SampleGamepads();
+        s_InstancePtr->_UpdateGamepads();
+    }
+
+    if (s_InstancePtr->Recording()) {
+        s_InstancePtr->_WriteRecordFrame();
+    }
+
+    for (InputActionMap* map : s_InstancePtr->ActionMaps) {
+        map->Update();
+    }
+}
+
+void Input::PumpEvents(double wait_timeout)
+{
+    PROFILE_SCOPE("Input::PumpEvents");
+    if (wait_timeout > 0.0) {
+        glfwWaitEventsTimeout(wait_timeout);
+    }
+    else {
+        glfwPollEvents();
+    }
+
+    // Joysticks can only be read on the main thread and have no events to wait on
+    std::lock_guard<std::mutex> lock(s_InstancePtr->PendingMutex);
+    s_InstancePtr->_SampleGamepads();
+}
+
+void Input::_ReceiveEvent(const InputEvent& event)
+{
+    if (Flags & Input_EventThreadBit) {
+        std::lock_guard<std::mutex> lock(PendingMutex);
+        PendingEvents.push_back(event);
+    }
+    else {
+        _ApplyEvent(event);
+    }
+}
+
+void Input::_ApplyEvent(const InputEvent& event)
+{
+    switch (event.Type) {
+    case InputEventType_Key:
+        if (event.Action != InputAction_Repeat) {
+            KeyState[event.Code] = event.Action == InputAction_Press;
+        }
+        break;
+    case InputEventType_MouseButton:
+        MouseState[event.Code] = event.Action == InputAction_Press;
+        break;
+    case InputEventType_MouseMove:
+        Cursor = event.Value;
+        break;
+    case InputEventType_Scroll:
+        Scroll += event.Value;
+        break;
+    case InputEventType_Resize:
+        Framebuffer = event.Value;
+        break;
+    case InputEventType_Char:
+        break;
+    }
+
+    if (RecordFile != nullptr) {
+        RecordEvents.push_back(event);
+    }
+
+    if (EventCount == Events.size()) {
+        DroppedEventCount++;
+        return;
+    }
+    Events[EventCount++] = event;
+}
+
+void Input::_SampleGamepads()
+{
+    InputGamepadSource* source = GamepadSourcePtr;
+    if (source == nullptr && !Replaying()) {
+        source = &GlfwGamepadSource;
+    }
+
+    for (int joystick = 0; joystick <= GamepadJoystick_LAST; joystick++) {
+        GamepadSamplesConnected[joystick] =
+            source != nullptr &&
+            source->ReadGamepad((GamepadJoystick)joystick, GamepadSamples[joystick]);
     }
 }
 
-bool Input::_RegisterOnce(InputType type, int code, bool pressed)
+void Input::_UpdateGamepads()
 {
-    int free_index = -1;
-    for (size_t i = 0; i < RegBuffer.size(); i++) {
-        if (RegBuffer[i].Type == InputType_Unknown) {
-            free_index = i;
+    for (int joystick = 0; joystick <= GamepadJoystick_LAST; joystick++) {
+        GamepadState& gamepad = Gamepads[joystick];
+        gamepad.PrevButtons   = gamepad.Buttons;
+        gamepad.Connected     = GamepadSamplesConnected[joystick];
+        if (!gamepad.Connected) {
+            gamepad.Buttons.reset();
+            gamepad.Axes.fill(0.0f);
+            gamepad.RawAxes.fill(0.0f);
             continue;
         }
-        bool found = RegBuffer[i].Type == type && RegBuffer[i].Code == code &&
-                     RegBuffer[i].Pressed == pressed;
-        if (found) {
-            RegBuffer[i].RemoveNextTick = false;
-            return false;
+
+        const GLFWgamepadstate& state = GamepadSamples[joystick];
+        for (int button = 0; button <= GamepadButton_Last; button++) {
+            gamepad.Buttons[button] = state.buttons[button] == GLFW_PRESS;
         }
+        std::copy_n(state.axes, gamepad.RawAxes.size(), gamepad.RawAxes.begin());
+
+        glm::vec2 left  = ApplyRadialDeadzone(glm::vec2(state.axes[GamepadAxis_LeftX],
+                                                        state.axes[GamepadAxis_LeftY]),
+                                              GamepadConfig);
+        glm::vec2 right = ApplyRadialDeadzone(glm::vec2(state.axes[GamepadAxis_RightX],
+                                                        state.axes[GamepadAxis_RightY]),
+                                              GamepadConfig);
+        gamepad.Axes[GamepadAxis_LeftX]  = left.x;
+        gamepad.Axes[GamepadAxis_LeftY]  = left.y;
+        gamepad.Axes[GamepadAxis_RightX] = right.x;
+        gamepad.Axes[GamepadAxis_RightY] = right.y;
+        gamepad.Axes[GamepadAxis_LeftTrigger] =
+            ApplyTriggerDeadzone(state.axes[GamepadAxis_LeftTrigger], GamepadConfig);
+        gamepad.Axes[GamepadAxis_RightTrigger] =
+            ApplyTriggerDeadzone(state.axes[GamepadAxis_RightTrigger], GamepadConfig);
     }
+}
 
-    CONTEXT_CONDITION_ERROR_RETURN("INPUT", free_index != -1, false,
-                                   "Toggle register buffer full, cannot add {} {}",
-                                   TypeToString(type), code);
+void Input::_WriteRecordFrame()
+{
+    uint64_t frame_time = RecordFrameTime;
+    RecordFrameTime     = Time::NowNanoseconds();
 
-    RegBuffer[free_index] = RegisteredInput {
-        .Type           = type,
-        .Code           = code,
-        .RemoveNextTick = false,
-        .Pressed        = pressed,
-    };
-    RegActiveCount++;
+    double delta   = Time::UnscaledDelta();
+    uint32_t count = (uint32_t)RecordEvents.size();
+    std::fwrite(&delta, sizeof(delta), 1, RecordFile);
+    std::fwrite(&count, sizeof(count), 1, RecordFile);
+
+    for (const InputEvent& event : RecordEvents) {
+        uint64_t offset = event.Timestamp > frame_time ? (event.Timestamp - frame_time) / 1000 : 0;
+        InputRecordEvent record = {
+            .Type       = (uint8_t)event.Type,
+            .Action     = (uint8_t)event.Action,
+            .Mods       = (uint16_t)event.Mods,
+            .Code       = (int32_t)event.Code,
+            .Value      = {event.Value.x, event.Value.y},
+            .TimeOffset = (uint32_t)std::min<uint64_t>(offset, UINT32_MAX),
+        };
+        std::fwrite(&record, sizeof(record), 1, RecordFile);
+    }
+    RecordEvents.clear();
+}
+
+bool Input::_ReadReplayFrame()
+{
+    ReplayEvents.clear();
+    ReplayFrameLoaded = false;
+
+    double delta;
+    uint32_t count;
+    if (std::fread(&delta, sizeof(delta), 1, ReplayFile) != 1 ||
+        std::fread(&count, sizeof(count), 1, ReplayFile) != 1) {
+        return false;
+    }
+
+    uint64_t frame_time = Time::NowNanoseconds();
+    for (uint32_t i = 0; i < count; i++) {
+        InputRecordEvent record;
+        CONTEXT_CONDITION_ERROR_RETURN("INPUT",
+                                       std::fread(&record, sizeof(record), 1, ReplayFile) == 1,
+                                       false, "Input recording ends partway through a frame");
+
+        int last = record.Type == InputEventType_Key           ? KeyCode_Last
+                   : record.Type == InputEventType_MouseButton ? MouseButton_Last
+                                                               : INT32_MAX;
+        bool valid =
+            record.Type <= InputEventType_Resize && (last == INT32_MAX || record.Code >= 0) &&
+            record.Code <= last;
+        CONTEXT_CONDITION_ERROR_RETURN("INPUT", valid, false,
+                                       "Input recording has a corrupt event");
+
+        ReplayEvents.push_back(InputEvent {
+            .Type      = (InputEventType)record.Type,
+            .Code      = record.Code,
+            .Action    = (InputAction)record.Action,
+            .Mods      = record.Mods,
+            .Value     = glm::vec2(record.Value[0], record.Value[1]),
+            .Timestamp = frame_time + (uint64_t)record.TimeOffset * 1000,
+        });
+    }
+
+    ReplayDelta       = delta;
+    ReplayFrameLoaded = true;
     return true;
 }
+
+void Input::_KeyCallback(GLFWwindow*, int key, int, int action, int mods)
+{
+    if (key < 0 || key > KeyCode_Last) {
+        return;
+    }
+    s_InstancePtr->_ReceiveEvent(InputEvent {
+        .Type      = InputEventType_Key,
+        .Code      = key,
+        .Action    = (InputAction)action,
+        .Mods      = mods,
+        .Timestamp = Time::NowNanoseconds(),
+    });
+}
+
+void Input::_MouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+{
+    if (button < 0 || button > MouseButton_Last) {
+        return;
+    }
+
+    double x, y;
+    glfwGetCursorPos(window, &x, &y);
+    s_InstancePtr->_ReceiveEvent(InputEvent {
+        .Type      = InputEventType_MouseButton,
+        .Code      = button,
+        .Action    = (InputAction)action,
+        .Mods      = mods,
+        .Value     = glm::vec2((float)x, (float)y),
+        .Timestamp = Time::NowNanoseconds(),
+    });
+}
+
+void Input::_CursorPosCallback(GLFWwindow*, double x, double y)
+{
+    s_InstancePtr->_ReceiveEvent(InputEvent {
+        .Type      = InputEventType_MouseMove,
+        .Value     = glm::vec2((float)x, (float)y),
+        .Timestamp = Time::NowNanoseconds(),
+    });
+}
+
+void Input::_ScrollCallback(GLFWwindow*, double x, double y)
+{
+    s_InstancePtr->_ReceiveEvent(InputEvent {
+        .Type      = InputEventType_Scroll,
+        .Value     = glm::vec2((float)x, (float)y),
+        .Timestamp = Time::NowNanoseconds(),
+    });
+}
+
+void Input::_CharCallback(GLFWwindow*, unsigned int codepoint)
+{
+    s_InstancePtr->_ReceiveEvent(InputEvent {
+        .Type      = InputEventType_Char,
+        .Code      = (int)codepoint,
+        .Timestamp = Time::NowNanoseconds(),
+    });
+}
+
+void Input::_FramebufferSizeCallback(GLFWwindow*, int width, int height)
+{
+    s_InstancePtr->_ReceiveEvent(InputEvent {
+        .Type      = InputEventType_Resize,
+        .Value     = glm::vec2((float)width, (float)height),
+        .Timestamp = Time::NowNanoseconds(),
+    });
+}
+
+void Input::_FocusCallback(GLFWwindow*, int focused)
+{
+    s_InstancePtr->Focused.store(focused == GLFW_TRUE, std::memory_order_relaxed);
+}
@@ -15,10 +15,17 @@
 
 #pragma once
 
+#include "Core/InputActionMap.h"
 #include "Core/InputKeyCodes.h"
 #include "RHI/WindowHandle.h"
 #include <array>
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
 #include <string_view>
+#include <vector>
 
 enum InputType {
     InputType_Unknown = -1,
@@ -35,21 +42,138 @@ enum MouseMode {
 
 };
 
-struct RegisteredInput {
-    InputType Type      = InputType_Unknown;
-    int Code            = -1;
-    bool RemoveNextTick = false;
-    bool Pressed        = false;
+enum InputFlags {
+    Input_NoneBit = 0,
+    // GLFW events are pumped by PumpEvents on the main thread while PollEvents, called from the
+    // simulation/render thread, applies whatever arrived since the last call
+    Input_EventThreadBit = 1 << 0,
+};
+
+enum InputEventType {
+    InputEventType_Key,
+    InputEventType_MouseButton,
+    InputEventType_MouseMove,
+    InputEventType_Scroll,
+    InputEventType_Char,
+    InputEventType_Resize,
+};
+
+enum InputAction {
+    InputAction_Release = GLFW_RELEASE,
+    InputAction_Press   = GLFW_PRESS,
+    InputAction_Repeat  = GLFW_REPEAT,
+};
+
+struct InputEvent {
+    InputEventType Type;
+    int Code           = -1; // KeyCode, MouseButton or unicode codepoint for Char events
+    InputAction Action = InputAction_Press;
+    int Mods           = 0; // KeyMod bits
+    glm::vec2 Value    = glm::vec2(0.0f); // Cursor position, scroll offset or framebuffer size
+    uint64_t Timestamp = 0;               // Time::NowNanoseconds when GLFW delivered it
+};
+
+struct GamepadSettings {
+    float InnerDeadzone    = 0.15f; // Radial, stick magnitudes below this read as zero
+    float OuterDeadzone    = 0.95f; // Magnitudes above this read as full deflection
+    float TriggerDeadzone  = 0.05f;
+    float ResponseExponent = 1.0f; // Applied after the deadzone, > 1 gives finer control near rest
+};
+
+struct GamepadState {
+    bool Connected = false;
+    std::bitset<GamepadButton_Last + 1> Buttons;
+    std::bitset<GamepadButton_Last + 1> PrevButtons;
+    std::array<float, GamepadAxis_Last + 1> Axes    = {}; // Deadzone and curve applied
+    std::array<float, GamepadAxis_Last + 1> RawAxes = {};
+};
+
+// Where gamepad state comes from, GLFW unless a different source is injected (e.g. a scripted
+// fake when there are no devices)
+struct InputGamepadSource {
+    virtual ~InputGamepadSource() = default;
+
+    // Returns false when nothing usable as a gamepad is connected at joystick
+    virtual bool ReadGamepad(GamepadJoystick joystick, GLFWgamepadstate& state) = 0;
+};
+
+struct InputGlfwGamepadSource : public InputGamepadSource {
+    bool ReadGamepad(GamepadJoystick joystick, GLFWgamepadstate& state) override;
+};
+
+struct InputEventView {
+    const InputEvent* Data = nullptr;
+    size_t Size            = 0;
+
+    inline const InputEvent* begin() const { return Data; }
+    inline const InputEvent* end() const { return Data + Size; }
 };
 
 struct Input {
-    static constexpr size_t RegisterOnceBufferSize = 16;
+    static constexpr size_t EventQueueCapacity = 256;
 
     WindowHandle* WindowPtr = nullptr;
-    size_t RegActiveCount   = 0;
-    std::array<RegisteredInput, RegisterOnceBufferSize> RegBuffer;
-
-    void Initialize(WindowHandle& window);
+    uint32_t Flags          = Input_NoneBit;
+
+    // Filled by the GLFW callbacks, queries never call back into GLFW. The previous state is the
+    // state at the end of the last frame, so an edge is a differing bit between the two
+    std::bitset<KeyCode_Last + 1> KeyState;
+    std::bitset<KeyCode_Last + 1> PrevKeyState;
+    std::bitset<MouseButton_Last + 1> MouseState;
+    std::bitset<MouseButton_Last + 1> PrevMouseState;
+    glm::vec2 Cursor      = glm::vec2(0.0f);
+    glm::vec2 Scroll      = glm::vec2(0.0f); // Accumulated over the frame
+    glm::vec2 Framebuffer = glm::vec2(0.0f);
+
+    // Events received during the last PollEvents, later events are dropped once full
+    std::array<InputEvent, EventQueueCapacity> Events;
+    size_t EventCount        = 0;
+    size_t DroppedEventCount = 0;
+
+    std::vector<InputActionMap*> ActionMaps; // Updated at the end of every PollEvents
+
+    // Every joystick is read once per PollEvents, queries only index this array
+    std::array<GamepadState, GamepadJoystick_LAST + 1> Gamepads;
+    GamepadSettings GamepadConfig;
+    InputGlfwGamepadSource GlfwGamepadSource;
+    InputGamepadSource* GamepadSourcePtr = nullptr;
+
+    // Raw samples read by whichever thread pumps GLFW, processed into Gamepads by PollEvents
+    std::array<GLFWgamepadstate, GamepadJoystick_LAST + 1> GamepadSamples;
+    std::bitset<GamepadJoystick_LAST + 1> GamepadSamplesConnected;
+
+    // Handoff from the event thread, guarded by PendingMutex
+    std::mutex PendingMutex;
+    std::vector<InputEvent> PendingEvents;
+    std::vector<InputEvent> DrainedEvents;
+    std::atomic<bool> Focused = true;
+
+    // Every event applied this frame, kept apart from Events so recordings never drop any
+    std::vector<InputEvent> RecordEvents;
+    std::FILE* RecordFile    = nullptr;
+    uint64_t RecordFrameTime = 0;
+
+    // The replay reads one frame ahead so the delta time is known before the frame starts
+    std::vector<InputEvent> ReplayEvents;
+    std::FILE* ReplayFile  = nullptr;
+    double ReplayDelta     = 0.0;
+    bool ReplayFrameLoaded = false;
+
+    void Initialize(WindowHandle& window, uint32_t flags = Input_NoneBit);
+    // Replays a recording without a window, PollEvents then applies the recorded frames
+    bool InitializeReplay(std::string_view path);
+    void Destroy();
+
+    // Writes every frame's events and Time::UnscaledDelta to path until StopRecording
+    bool StartRecording(std::string_view path);
+    void StopRecording();
+
+    inline bool Recording() const { return RecordFile != nullptr; }
+    inline bool Replaying() const { return ReplayFile != nullptr; }
+    inline bool ReplayFinished() const { return Replaying() && !ReplayFrameLoaded; }
+
+    // Delta time recorded for the upcoming frame, feed it to Time::Update when replaying
+    inline double ReplayDeltaTime() const { return ReplayDelta; }
 
     static bool KeyPressed(KeyCode code);
     static bool KeyReleased(KeyCode code);
@@ -63,11 +187,49 @@ struct Input {
     static bool MousePress(MouseButton button);
     static bool MouseRelease(MouseButton button);
 
+    static glm::vec2 MousePosition();
+    static glm::vec2 MouseScroll();
+    static glm::vec2 FramebufferSize();
+    static bool WindowFocused();
+    static InputEventView FrameEvents();
+
+    static bool GamepadConnected(GamepadJoystick joystick);
+    static bool GamepadButtonPressed(GamepadJoystick joystick, GamepadButton button);
+    static bool GamepadButtonReleased(GamepadJoystick joystick, GamepadButton button);
+    static bool GamepadButtonPress(GamepadJoystick joystick, GamepadButton button);
+    static float GamepadAxisValue(GamepadJoystick joystick, GamepadAxis axis);
+    static glm::vec2 GamepadStick(GamepadJoystick joystick, bool right = false);
+
+    // Source used by PollEvents, nullptr restores GLFW. Replays read no gamepads unless a
+    // source is set, since there is no GLFW to read from
+    static void SetGamepadSource(InputGamepadSource* source);
+
+    static void AddActionMap(InputActionMap& map);
+    static void RemoveActionMap(InputActionMap& map);
+
     static std::string_view TypeToString(InputType type);
     static std::string_view MouseModeToString(MouseMode mode);
 
-    void PollEvents();
+    // Blocks for up to wait_timeout seconds when there are no events, 0 polls without blocking.
+    // With Input_EventThreadBit it never touches GLFW and only applies events already pumped
+    void PollEvents(double wait_timeout = 0.0);
+
+    // Main thread side of Input_EventThreadBit, takes the same timeout as PollEvents
+    static void PumpEvents(double wait_timeout = 0.0);
 
 private:
-    bool _RegisterOnce(InputType type, int code, bool pressed);
+    void _ReceiveEvent(const InputEvent& event);
+    void _ApplyEvent(const InputEvent& event);
+    void _SampleGamepads();
+    void _UpdateGamepads();
+    void _WriteRecordFrame();
+    bool _ReadReplayFrame();
+
+    static void _KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+    static void _MouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+    static void _CursorPosCallback(GLFWwindow* window, double x, double y);
+    static void _ScrollCallback(GLFWwindow* window, double x, double y);
+    static void _CharCallback(GLFWwindow* window, unsigned int codepoint);
+    static void _FramebufferSizeCallback(GLFWwindow* window, int width, int height);
+    static void _FocusCallback(GLFWwindow* window, int focused);
 };
@@ -0,0 +1,131 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Core/InputActionMap.h"
+#include "Core/Console.h"
+#include "Core/Input.h"
+#include <algorithm>
+#include <cmath>
+
+InputActionId InputActionMap::AddAction(std::string_view name, InputActionType type)
+{
+    CONTEXT_CONDITION_ERROR_RETURN("INPUT", Find(name) == InputAction_Invalid, Find(name),
+                                   "Input action '{}' already exists", name);
+    CONTEXT_CONDITION_ERROR_RETURN("INPUT", Names.size() < InputAction_Invalid,
+                                   InputAction_Invalid, "Too many input actions to add '{}'",
+                                   name);
+
+    Names.emplace_back(name);
+    Types.push_back(type);
+    Bindings.emplace_back();
+    States.emplace_back();
+    Dirty = true;
+    return (InputActionId)(Names.size() - 1);
+}
+
+InputActionId InputActionMap::Find(std::string_view name) const
+{
+    for (size_t i = 0; i < Names.size(); i++) {
+        if (Names[i] == name) {
+            return (InputActionId)i;
+        }
+    }
+    return InputAction_Invalid;
+}
+
+void InputActionMap::Bind(InputActionId action, const InputBinding& binding)
+{
+    CONTEXT_CONDITION_ERROR("INPUT", action < Names.size(), "Invalid input action {}", action);
+    Bindings[action].push_back(binding);
+    Dirty = true;
+}
+
+void InputActionMap::Rebind(InputActionId action, size_t index, const InputBinding& binding)
+{
+    CONTEXT_CONDITION_ERROR("INPUT", action < Names.size(), "Invalid input action {}", action);
+    CONTEXT_CONDITION_ERROR("INPUT", index < Bindings[action].size(),
+                            "Input action '{}' has no binding {}", Names[action], index);
+    Bindings[action][index] = binding;
+    Dirty                   = true;
+}
+
+void InputActionMap::ClearBindings(InputActionId action)
+{
+    CONTEXT_CONDITION_ERROR("INPUT", action < Names.size(), "Invalid input action {}", action);
+    Bindings[action].clear();
+    Dirty = true;
+}
+
+void InputActionMap::Compile()
+{
+    CompiledBindings.clear();
+    for (size_t action = 0; action < Bindings.size(); action++) {
+        for (const InputBinding& binding : Bindings[action]) {
+            CompiledBindings.push_back(InputCompiledBinding {
+                .Source  = binding.Source,
+                .Code    = binding.Code,
+                .Scale   = binding.Scale,
+                .Gamepad = binding.Gamepad,
+                .Action  = (InputActionId)action,
+            });
+        }
+    }
+    Dirty = false;
+}
+
+void InputActionMap::Update()
+{
+    if (Dirty) {
+        Compile();
+    }
+
+    for (InputActionState& state : States) {
+        state.Value = 0.0f;
+    }
+
+    for (const InputCompiledBinding& binding : CompiledBindings) {
+        float value = 0.0f;
+        switch (binding.Source) {
+        case InputBindingSource_Key:
+            value = Input::KeyPress((KeyCode)binding.Code) ? 1.0f : 0.0f;
+            break;
+        case InputBindingSource_MouseButton:
+            value = Input::MousePress((MouseButton)binding.Code) ? 1.0f : 0.0f;
+            break;
+        case InputBindingSource_GamepadButton:
+            if (Input::GamepadButtonPress(binding.Gamepad, (GamepadButton)binding.Code)) {
+                value = 1.0f;
+            }
+            break;
+        case InputBindingSource_GamepadAxis:
+            value = Input::GamepadAxisValue(binding.Gamepad, (GamepadAxis)binding.Code);
+            break;
+        }
+        States[binding.Action].Value += value * binding.Scale;
+    }
+
+    for (size_t action = 0; action < States.size(); action++) {
+        InputActionState& state = States[action];
+        state.Value             = std::clamp(state.Value, -1.0f, 1.0f);
+        if (Types[action] == InputActionType_Axis) {
+            continue;
+        }
+
+        bool down      = std::fabs(state.Value) >= ButtonThreshold;
+        state.Pressed  = down && !state.Down;
+        state.Released = !down && state.Down;
+        state.Down     = down;
+    }
+}
@@ -0,0 +1,94 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "Core/InputKeyCodes.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using InputActionId = uint16_t;
+
+static constexpr InputActionId InputAction_Invalid = UINT16_MAX;
+
+// Buttons are down once their value reaches ButtonThreshold, axes only report a value and are
+// never down, pressed or released
+enum InputActionType {
+    InputActionType_Button,
+    InputActionType_Axis,
+};
+
+enum InputBindingSource {
+    InputBindingSource_Key,
+    InputBindingSource_MouseButton,
+    InputBindingSource_GamepadButton,
+    InputBindingSource_GamepadAxis,
+};
+
+struct InputBinding {
+    InputBindingSource Source = InputBindingSource_Key;
+    int Code                  = -1;
+    float Scale               = 1.0f; // e.g. -1 for the key that moves along the negative axis
+    GamepadJoystick Gamepad   = GamepadJoystick_1;
+};
+
+struct InputActionState {
+    float Value   = 0.0f; // Sum of the bound inputs clamped to [-1, 1]
+    bool Down     = false; // Always false for axis actions
+    bool Pressed  = false; // Became down this frame
+    bool Released = false;
+};
+
+// Flattened form of one binding, sorted by action so evaluation walks the table linearly
+struct InputCompiledBinding {
+    InputBindingSource Source;
+    int Code;
+    float Scale;
+    GamepadJoystick Gamepad;
+    InputActionId Action;
+};
+
+struct InputActionMap {
+    float ButtonThreshold = 0.5f; // Magnitude at which a button action counts as down
+
+    std::vector<std::string> Names;
+    std::vector<InputActionType> Types;
+    std::vector<std::vector<InputBinding>> Bindings;
+
+    std::vector<InputCompiledBinding> CompiledBindings;
+    std::vector<InputActionState> States; // Indexed by InputActionId
+    bool Dirty = true;
+
+    InputActionId AddAction(std::string_view name, InputActionType type = InputActionType_Button);
+    InputActionId Find(std::string_view name) const;
+
+    void Bind(InputActionId action, const InputBinding& binding);
+    void Rebind(InputActionId action, size_t index, const InputBinding& binding);
+    void ClearBindings(InputActionId action);
+
+    // Flattens the bindings into CompiledBindings, called by Update when bindings changed
+    void Compile();
+
+    // Evaluates every binding once, done by Input::PollEvents for registered maps
+    void Update();
+
+    inline const InputActionState& State(InputActionId action) const { return States[action]; }
+    inline float Value(InputActionId action) const { return States[action].Value; }
+    inline bool Down(InputActionId action) const { return States[action].Down; }
+    inline bool Pressed(InputActionId action) const { return States[action].Pressed; }
+    inline bool Released(InputActionId action) const { return States[action].Released; }
+};
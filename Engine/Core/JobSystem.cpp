@@ -0,0 +1,514 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Core/JobSystem.h"
+#include "Core/Console.h"
+#include "Core/Profiler.h"
+#include <cstdio>
+
+static_assert(sizeof(Job) == 128, "Job should span exactly two cache lines");
+
+static JobSystem* s_InstancePtr         = nullptr;
+static thread_local JobWorker* s_Worker = nullptr;
+
+// Marks a job's waiter list once the job has finished, fibers arriving later don't park
+static Fiber* const s_FinishedWaiters = reinterpret_cast<Fiber*>(uintptr_t(1));
+
+template <typename T, int64_t TCapacity>
+bool JobWorkStealingQueue<T, TCapacity>::Push(T* item)
+{
+    int64_t bottom = Bottom.load(std::memory_order_relaxed);
+    int64_t top    = Top.load(std::memory_order_acquire);
+    if (bottom - top >= Capacity) {
+        return false;
+    }
+    Items[bottom & (Capacity - 1)].store(item, std::memory_order_relaxed);
+    Bottom.store(bottom + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T, int64_t TCapacity>
+T* JobWorkStealingQueue<T, TCapacity>::Pop()
+{
+    int64_t bottom = Bottom.load(std::memory_order_relaxed) - 1;
+    Bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = Top.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+        Bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    T* item = Items[bottom & (Capacity - 1)].load(std::memory_order_relaxed);
+    if (top == bottom) {
+        // Last item, race any stealers for it
+        if (!Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                         std::memory_order_relaxed)) {
+            item = nullptr;
+        }
+        Bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return item;
+}
+
+template <typename T, int64_t TCapacity>
+T* JobWorkStealingQueue<T, TCapacity>::Steal()
+{
+    int64_t top = Top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = Bottom.load(std::memory_order_acquire);
+    if (top >= bottom) {
+        return nullptr;
+    }
+
+    T* item = Items[top & (Capacity - 1)].load(std::memory_order_relaxed);
+    if (!Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                     std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return item;
+}
+
+template struct JobWorkStealingQueue<Job, JobWorker::QueueCapacity>;
+template struct JobWorkStealingQueue<Fiber, JobWorker::ReadyFiberCapacity>;
+
+void JobSystem::Initialize(int worker_count, uint32_t flags)
+{
+    if (worker_count < 0) {
+        worker_count = (int)std::thread::hardware_concurrency() - 1;
+    }
+    if (worker_count < 0) {
+        worker_count = 0;
+    }
+
+    s_InstancePtr = this;
+    Flags         = flags;
+    Running.store(true);
+    Workers.resize((size_t)worker_count + 1);
+    for (size_t i = 0; i < Workers.size(); i++) {
+        JobWorker* worker   = new JobWorker;
+        worker->Pool        = new Job[JobWorker::PoolSize];
+        worker->Index       = (uint32_t)i;
+        worker->RandomState = (uint32_t)i * 2654435761u + 1;
+        Workers[i]          = worker;
+    }
+
+    if (Flags & JobSystem_FibersBit) {
+        uint32_t fiber_count = FiberPoolSize + (uint32_t)Workers.size();
+        Fibers               = new Fiber[fiber_count];
+        CONTEXT_CONDITION_FATAL("JOBS", fiber_count < JobWorker::ReadyFiberCapacity,
+                                "{} fibers overflow the ready fiber queues", fiber_count);
+        FreeFibers.reserve(fiber_count);
+        for (uint32_t i = 0; i < fiber_count; i++) {
+            Fibers[i].Id = i + 1;
+            Fibers[i].Initialize(&JobSystem::_FiberMain, nullptr);
+            FreeFibers.push_back(&Fibers[fiber_count - i - 1]);
+        }
+    }
+
+    s_Worker = Workers[0];
+    for (size_t i = 1; i < Workers.size(); i++) {
+        Threads.emplace_back(&JobSystem::_WorkerMain, this, Workers[i]);
+    }
+    CONTEXT_INFO("JOBS", "Started job system with {} worker threads{}", Threads.size(),
+                 (Flags & JobSystem_FibersBit) ? " running fibers" : "");
+}
+
+void JobSystem::Destroy()
+{
+    Running.store(false);
+    {
+        std::lock_guard<std::mutex> lock(SleepMutex);
+        SleepSignal.notify_all();
+    }
+    for (std::thread& thread : Threads) {
+        thread.join();
+    }
+    Threads.clear();
+
+    if (Fibers != nullptr) {
+        uint32_t fiber_count = FiberPoolSize + (uint32_t)Workers.size();
+        for (uint32_t i = 0; i < fiber_count; i++) {
+            Fibers[i].Destroy();
+        }
+        delete[] Fibers;
+        Fibers = nullptr;
+        FreeFibers.clear();
+    }
+
+    for (JobWorker* worker : Workers) {
+        delete[] worker->Pool;
+        delete worker;
+    }
+    Workers.clear();
+    s_Worker      = nullptr;
+    s_InstancePtr = nullptr;
+}
+
+uint32_t JobSystem::WorkerCount()
+{
+    return (uint32_t)s_InstancePtr->Workers.size();
+}
+
+uint32_t JobSystem::CurrentWorkerIndex()
+{
+    JobWorker* worker = _CurrentWorker();
+    return worker != nullptr ? worker->Index : UINT32_MAX;
+}
+
+Job* JobSystem::CreateJob(JobFunction function, const void* data, size_t size)
+{
+    return CreateChildJob(nullptr, function, data, size);
+}
+
+Job* JobSystem::CreateChildJob(Job* parent, JobFunction function, const void* data, size_t size)
+{
+    CONTEXT_CONDITION_FATAL("JOBS", size <= Job::DataSize, "Job data of {} bytes is too large",
+                            size);
+    if (parent != nullptr) {
+        parent->UnfinishedJobs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Job* job      = _AllocateJob();
+    job->Function = function;
+    job->Parent   = parent;
+    job->UnfinishedJobs.store(1, std::memory_order_relaxed);
+    job->ContinuationCount.store(0, std::memory_order_relaxed);
+    job->Waiters.store(nullptr, std::memory_order_relaxed);
+    if (size > 0) {
+        std::memcpy(job->Data, data, size);
+    }
+    return job;
+}
+
+bool JobSystem::AddContinuation(Job* ancestor, Job* continuation)
+{
+    int32_t index = ancestor->ContinuationCount.fetch_add(1, std::memory_order_relaxed);
+    CONTEXT_CONDITION_ERROR_RETURN("JOBS", index < (int32_t)Job::MaxContinuations, false,
+                                   "Job already has {} continuations", Job::MaxContinuations);
+    ancestor->Continuations[index] = continuation;
+    return true;
+}
+
+void JobSystem::Run(Job* job)
+{
+    if (!_CurrentWorker()->Queue.Push(job)) {
+        // Queue is full, running inline keeps forward progress
+        _Execute(job);
+        return;
+    }
+    if (s_InstancePtr->SleepingCount.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(s_InstancePtr->SleepMutex);
+        s_InstancePtr->SleepSignal.notify_one();
+    }
+}
+
+bool JobSystem::Finished(const Job* job)
+{
+    return job->UnfinishedJobs.load(std::memory_order_acquire) == 0;
+}
+
+void JobSystem::Wait(const Job* job)
+{
+    if (Finished(job)) {
+        return;
+    }
+    if (_CurrentWorker()->CurrentFiber != nullptr && _ParkFiber(job)) {
+        return;
+    }
+
+    while (!Finished(job)) {
+        Job* next = _GetJob();
+        if (next != nullptr) {
+            _Execute(next);
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// Fibers can resume on a different thread than they were suspended on, the compiler must not
+// be allowed to reuse a thread local address computed before a switch
+#ifdef _MSC_VER
+__declspec(noinline)
+#else
+__attribute__((noinline))
+#endif
+JobWorker* JobSystem::_CurrentWorker()
+{
+    return s_Worker;
+}
+
+Job* JobSystem::_AllocateJob()
+{
+    JobWorker* worker = _CurrentWorker();
+    CONTEXT_CONDITION_FATAL("JOBS", worker != nullptr,
+                            "Jobs can only be created from job system worker threads");
+    uint32_t index = worker->AllocatedJobs++;
+    Job* job       = &worker->Pool[index & (JobWorker::PoolSize - 1)];
+    CONTEXT_CONDITION_FATAL("JOBS", job->UnfinishedJobs.load(std::memory_order_acquire) == 0,
+                            "Job ring of worker {} wrapped onto an unfinished job, more than {} "
+                            "jobs are alive at once",
+                            worker->Index, JobWorker::PoolSize);
+    return job;
+}
+
+Job* JobSystem::_GetJob()
+{
+    JobWorker* worker = _CurrentWorker();
+    Job* job          = worker->Queue.Pop();
+    if (job != nullptr) {
+        return job;
+    }
+
+    uint32_t worker_count = (uint32_t)s_InstancePtr->Workers.size();
+    if (worker_count < 2) {
+        return nullptr;
+    }
+
+    // xorshift, start stealing from a random victim so idle workers don't all hit the same one
+    uint32_t& state = worker->RandomState;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    uint32_t start = state % worker_count;
+    for (uint32_t i = 0; i < worker_count; i++) {
+        JobWorker* victim = s_InstancePtr->Workers[(start + i) % worker_count];
+        if (victim == worker) {
+            continue;
+        }
+        job = victim->Queue.Steal();
+        if (job != nullptr) {
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::_Execute(Job* job)
+{
+    job->Function(job, job->Data);
+    _Finish(job);
+}
+
+void JobSystem::_Finish(Job* job)
+{
+    // Continuations must be read before the count reaches zero, after that the slot may be
+    // reused by its owning worker
+    int32_t continuation_count = job->ContinuationCount.load(std::memory_order_relaxed);
+    Job* continuations[Job::MaxContinuations];
+    for (int32_t i = 0; i < continuation_count && i < (int32_t)Job::MaxContinuations; i++) {
+        continuations[i] = job->Continuations[i];
+    }
+    Job* parent = job->Parent;
+
+    if (job->UnfinishedJobs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    _WakeWaiters(job);
+    if (parent != nullptr) {
+        _Finish(parent);
+    }
+    for (int32_t i = 0; i < continuation_count && i < (int32_t)Job::MaxContinuations; i++) {
+        Run(continuations[i]);
+    }
+}
+
+bool JobSystem::_RunNext(uint32_t& idle_count)
+{
+    Job* job = _GetJob();
+    if (job != nullptr) {
+        _Execute(job);
+        idle_count = 0;
+        return true;
+    }
+
+    if (++idle_count < 64) {
+        std::this_thread::yield();
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(s_InstancePtr->SleepMutex);
+    s_InstancePtr->SleepingCount.fetch_add(1);
+    s_InstancePtr->SleepSignal.wait_for(lock, std::chrono::milliseconds(1));
+    s_InstancePtr->SleepingCount.fetch_sub(1);
+    return false;
+}
+
+void JobSystem::_WorkerMain(JobWorker* worker)
+{
+    s_Worker = worker;
+
+#ifdef KRYOS_PROFILE
+    char thread_name[32];
+    std::snprintf(thread_name, sizeof(thread_name), "Job Worker %u", worker->Index);
+    PROFILE_THREAD_NAME(thread_name);
+#endif
+
+    if (Flags & JobSystem_FibersBit) {
+        worker->SchedulerFiber.InitializeFromThread();
+        worker->CurrentFiber = _AcquireFiber();
+        worker->SchedulerFiber.SwitchTo(*worker->CurrentFiber);
+
+        // Back once the fiber that ended up on this thread has seen Running go false
+        worker               = _CurrentWorker();
+        worker->CurrentFiber = nullptr;
+        worker->SchedulerFiber.Destroy();
+        Console::SetFiberId(0);
+    }
+    else {
+        uint32_t idle_count = 0;
+        while (Running.load(std::memory_order_relaxed)) {
+            _RunNext(idle_count);
+        }
+    }
+    s_Worker = nullptr;
+}
+
+Fiber* JobSystem::_AcquireFiber()
+{
+    std::lock_guard<std::mutex> lock(s_InstancePtr->FiberMutex);
+    if (s_InstancePtr->FreeFibers.empty()) {
+        return nullptr;
+    }
+    Fiber* fiber = s_InstancePtr->FreeFibers.back();
+    s_InstancePtr->FreeFibers.pop_back();
+    return fiber;
+}
+
+Fiber* JobSystem::_AcquireReadyFiber()
+{
+    JobWorker* worker = _CurrentWorker();
+    Fiber* fiber      = worker->ReadyFibers.Pop();
+    if (fiber != nullptr) {
+        return fiber;
+    }
+
+    uint32_t worker_count = (uint32_t)s_InstancePtr->Workers.size();
+    for (uint32_t i = 1; i < worker_count; i++) {
+        JobWorker* victim = s_InstancePtr->Workers[(worker->Index + i) % worker_count];
+        fiber             = victim->ReadyFibers.Steal();
+        if (fiber != nullptr) {
+            return fiber;
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::_ReadyFiber(Fiber* fiber)
+{
+    bool pushed = _CurrentWorker()->ReadyFibers.Push(fiber);
+    CONTEXT_CONDITION_FATAL("JOBS", pushed, "Ready fiber queue is full");
+    if (s_InstancePtr->SleepingCount.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(s_InstancePtr->SleepMutex);
+        s_InstancePtr->SleepSignal.notify_one();
+    }
+}
+
+void JobSystem::_AddWaiter(const Job* job, Fiber* fiber)
+{
+    Fiber* head = job->Waiters.load(std::memory_order_acquire);
+    do {
+        if (head == s_FinishedWaiters) {
+            // Finished between Wait checking it and the fiber being switched out
+            _ReadyFiber(fiber);
+            return;
+        }
+        fiber->Next = head;
+    } while (!job->Waiters.compare_exchange_weak(head, fiber, std::memory_order_acq_rel,
+                                                 std::memory_order_acquire));
+}
+
+void JobSystem::_WakeWaiters(Job* job)
+{
+    Fiber* fiber = job->Waiters.exchange(s_FinishedWaiters, std::memory_order_acq_rel);
+    while (fiber != nullptr) {
+        // Next has to be read first, the fiber may be resumed and park again straight away
+        Fiber* next = fiber->Next;
+        _ReadyFiber(fiber);
+        fiber = next;
+    }
+}
+
+bool JobSystem::_ParkFiber(const Job* job)
+{
+    Fiber* next = _AcquireReadyFiber();
+    if (next == nullptr) {
+        next = _AcquireFiber();
+    }
+    if (next == nullptr) {
+        // Pool exhausted, the caller falls back to running jobs on this stack
+        return false;
+    }
+
+    JobWorker* worker        = _CurrentWorker();
+    Fiber* current           = worker->CurrentFiber;
+    worker->PendingWaitFiber = current;
+    worker->PendingWaitJob   = job;
+    worker->CurrentFiber     = next;
+    current->SwitchTo(*next);
+
+    _AfterSwitch();
+    return true;
+}
+
+void JobSystem::_AfterSwitch()
+{
+    JobWorker* worker = _CurrentWorker();
+    Console::SetFiberId(worker->CurrentFiber != nullptr ? worker->CurrentFiber->Id : 0);
+    if (worker->PendingFreeFiber == nullptr && worker->PendingWaitFiber == nullptr) {
+        return;
+    }
+
+    if (worker->PendingFreeFiber != nullptr) {
+        std::lock_guard<std::mutex> lock(s_InstancePtr->FiberMutex);
+        s_InstancePtr->FreeFibers.push_back(worker->PendingFreeFiber);
+        worker->PendingFreeFiber = nullptr;
+    }
+    if (worker->PendingWaitFiber != nullptr) {
+        Fiber* fiber             = worker->PendingWaitFiber;
+        const Job* job           = worker->PendingWaitJob;
+        worker->PendingWaitFiber = nullptr;
+        worker->PendingWaitJob   = nullptr;
+        _AddWaiter(job, fiber);
+    }
+}
+
+void JobSystem::_FiberMain(void*)
+{
+    _AfterSwitch();
+
+    uint32_t idle_count = 0;
+    while (s_InstancePtr->Running.load(std::memory_order_relaxed)) {
+        // Resuming a parked fiber takes priority over starting new work, this fiber goes back
+        // to the pool where it stays suspended right here until reused
+        Fiber* ready = _AcquireReadyFiber();
+        if (ready != nullptr) {
+            JobWorker* worker        = _CurrentWorker();
+            Fiber* current           = worker->CurrentFiber;
+            worker->PendingFreeFiber = current;
+            worker->CurrentFiber     = ready;
+            current->SwitchTo(*ready);
+            _AfterSwitch();
+            idle_count = 0;
+            continue;
+        }
+        _RunNext(idle_count);
+    }
+
+    JobWorker* worker = _CurrentWorker();
+    worker->CurrentFiber->SwitchTo(worker->SchedulerFiber);
+}
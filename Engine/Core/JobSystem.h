@@ -0,0 +1,223 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "Core/Fiber.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+struct Job;
+using JobFunction = void (*)(Job* job, const void* data);
+
+// A unit of work plus its dependency counter. UnfinishedJobs starts at 1 for the job itself and
+// is incremented for every child, the job counts as finished once it and all of its children
+// have run. Continuations are scheduled and fibers parked on the job are made ready when that
+// happens. Jobs live in a per-worker ring, so a handle is only valid until the ring wraps
+// (JobWorker::PoolSize jobs later on that worker)
+struct alignas(64) Job {
+    static constexpr size_t MaxContinuations = 4;
+    static constexpr size_t DataSize         = 64;
+
+    JobFunction Function = nullptr;
+    Job* Parent          = nullptr;
+    std::atomic<int32_t> UnfinishedJobs {0};
+    std::atomic<int32_t> ContinuationCount {0};
+    mutable std::atomic<Fiber*> Waiters {nullptr}; // Parked fibers, linked through Fiber::Next
+    Job* Continuations[MaxContinuations];
+    alignas(8) unsigned char Data[DataSize];
+};
+
+// Chase-Lev work stealing deque. The owning worker pushes and pops at the bottom, every other
+// worker steals from the top
+template <typename T, int64_t TCapacity>
+struct JobWorkStealingQueue {
+    static constexpr int64_t Capacity = TCapacity;
+
+    alignas(64) std::atomic<int64_t> Top {0};
+    alignas(64) std::atomic<int64_t> Bottom {0};
+    std::atomic<T*> Items[Capacity];
+
+    bool Push(T* item);
+    T* Pop();
+    T* Steal();
+};
+
+enum JobSystemFlags : uint32_t {
+    JobSystem_NoneBit = 0,
+    // Worker threads run jobs inside fibers, a job waiting on another job parks its fiber and
+    // the worker carries on with a different one instead of blocking
+    JobSystem_FibersBit = 1 << 0,
+};
+
+struct JobWorker {
+    static constexpr uint32_t PoolSize          = 4096;
+    static constexpr int64_t QueueCapacity      = 4096;
+    static constexpr int64_t ReadyFiberCapacity = 1024; // Must exceed the fiber count
+
+    JobWorkStealingQueue<Job, QueueCapacity> Queue;
+    Job* Pool              = nullptr;
+    uint32_t AllocatedJobs = 0;
+    uint32_t Index         = 0;
+    uint32_t RandomState   = 0;
+
+    // Fiber mode only. Fibers whose job finished on this worker wait in ReadyFibers until this
+    // or another worker resumes them. The Pending* fibers are handed over by whichever fiber
+    // runs next on this worker, as their stacks are still in use until the switch has happened
+    JobWorkStealingQueue<Fiber, ReadyFiberCapacity> ReadyFibers;
+    Fiber SchedulerFiber;
+    Fiber* CurrentFiber       = nullptr;
+    Fiber* PendingFreeFiber   = nullptr;
+    Fiber* PendingWaitFiber   = nullptr;
+    const Job* PendingWaitJob = nullptr;
+};
+
+struct JobSystem {
+    static constexpr uint32_t FiberPoolSize         = 128;
+    static constexpr uint32_t MaxParallelForBatches = JobWorker::PoolSize / 16;
+
+    uint32_t Flags = JobSystem_NoneBit;
+    std::vector<JobWorker*> Workers; // Index 0 is the thread that called Initialize
+    std::vector<std::thread> Threads;
+    std::atomic<bool> Running {false};
+
+    std::mutex SleepMutex;
+    std::condition_variable SleepSignal;
+    std::atomic<int32_t> SleepingCount {0};
+
+    Fiber* Fibers = nullptr;
+    std::vector<Fiber*> FreeFibers;
+    std::mutex FiberMutex; // Only guards FreeFibers
+
+    // Spawns worker_count threads, -1 uses one per hardware thread minus the calling thread
+    void Initialize(int worker_count = -1, uint32_t flags = JobSystem_NoneBit);
+    void Destroy();
+
+    static uint32_t WorkerCount();
+    static uint32_t CurrentWorkerIndex();
+
+    // Jobs can only be created from the worker threads (including the main thread)
+    static Job* CreateJob(JobFunction function, const void* data = nullptr, size_t size = 0);
+    static Job* CreateChildJob(Job* parent, JobFunction function, const void* data = nullptr,
+                               size_t size = 0);
+
+    template <typename TData>
+    static Job* CreateJob(JobFunction function, const TData& data);
+    template <typename TData>
+    static Job* CreateChildJob(Job* parent, JobFunction function, const TData& data);
+
+    // Schedules continuation once ancestor has finished, must be added before ancestor is run
+    static bool AddContinuation(Job* ancestor, Job* continuation);
+
+    static void Run(Job* job);
+    static bool Finished(const Job* job);
+
+    // Executes other jobs on the calling thread until job has finished. Inside a fiber the
+    // fiber is parked instead and resumed, possibly on another worker, once job has finished
+    static void Wait(const Job* job);
+
+    // Splits [0, count) into batches of at most batch_size and calls function(begin, end) for
+    // each batch across all workers. function must outlive the returned job. batch_size is
+    // raised when count would need more than MaxParallelForBatches, the split creates up to
+    // twice as many jobs as batches and all of them stay alive until the last batch finishes
+    template <typename TFunction>
+    static Job* ParallelFor(uint32_t count, uint32_t batch_size, const TFunction& function);
+
+private:
+    template <typename TFunction>
+    struct _ParallelForData {
+        uint32_t Begin;
+        uint32_t Count;
+        uint32_t BatchSize;
+        const TFunction* Function;
+    };
+
+    template <typename TFunction>
+    static void _ParallelForJob(Job* job, const void* data);
+
+    static JobWorker* _CurrentWorker();
+    static Job* _AllocateJob();
+    static Job* _GetJob();
+    static void _Execute(Job* job);
+    static void _Finish(Job* job);
+    static bool _RunNext(uint32_t& idle_count);
+    void _WorkerMain(JobWorker* worker);
+
+    static Fiber* _AcquireFiber();
+    static Fiber* _AcquireReadyFiber();
+    static void _ReadyFiber(Fiber* fiber);
+    static void _AddWaiter(const Job* job, Fiber* fiber);
+    static void _WakeWaiters(Job* job);
+    static bool _ParkFiber(const Job* job);
+    static void _AfterSwitch();
+    static void _FiberMain(void* data);
+};
+
+template <typename TData>
+Job* JobSystem::CreateJob(JobFunction function, const TData& data)
+{
+    static_assert(std::is_trivially_copyable_v<TData>, "Job data is copied byte wise");
+    static_assert(sizeof(TData) <= Job::DataSize, "Job data does not fit in Job::Data");
+    return CreateJob(function, &data, sizeof(TData));
+}
+
+template <typename TData>
+Job* JobSystem::CreateChildJob(Job* parent, JobFunction function, const TData& data)
+{
+    static_assert(std::is_trivially_copyable_v<TData>, "Job data is copied byte wise");
+    static_assert(sizeof(TData) <= Job::DataSize, "Job data does not fit in Job::Data");
+    return CreateChildJob(parent, function, &data, sizeof(TData));
+}
+
+template <typename TFunction>
+Job* JobSystem::ParallelFor(uint32_t count, uint32_t batch_size, const TFunction& function)
+{
+    uint32_t min_batch_size = (count + MaxParallelForBatches - 1) / MaxParallelForBatches;
+    _ParallelForData<TFunction> data {
+        .Begin     = 0,
+        .Count     = count,
+        .BatchSize = std::max({batch_size, min_batch_size, 1u}),
+        .Function  = &function,
+    };
+    return CreateJob(&JobSystem::_ParallelForJob<TFunction>, data);
+}
+
+template <typename TFunction>
+void JobSystem::_ParallelForJob(Job* job, const void* data)
+{
+    const auto& range = *(const _ParallelForData<TFunction>*)data;
+    if (range.Count > range.BatchSize) {
+        uint32_t left_count = range.Count / 2;
+
+        _ParallelForData<TFunction> left = range;
+        left.Count                       = left_count;
+        Run(CreateChildJob(job, &JobSystem::_ParallelForJob<TFunction>, left));
+
+        _ParallelForData<TFunction> right = range;
+        right.Begin                       = range.Begin + left_count;
+        right.Count                       = range.Count - left_count;
+        Run(CreateChildJob(job, &JobSystem::_ParallelForJob<TFunction>, right));
+    }
+    else {
+        (*range.Function)(range.Begin, range.Begin + range.Count);
+    }
+}
@@ -0,0 +1,152 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Core/Profiler.h"
+#include "Core/Console.h"
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Buffers outlive their threads so that zones from finished workers still make it into the trace
+static std::mutex s_BuffersMutex;
+static std::vector<std::unique_ptr<ProfilerThreadBuffer>> s_Buffers;
+static thread_local ProfilerThreadBuffer* s_Buffer = nullptr;
+
+static void WriteEscaped(std::FILE* file, const char* str)
+{
+    for (; *str != '\0'; str++) {
+        if ((unsigned char)*str < 0x20) {
+            std::fprintf(file, "\\u%04x", (unsigned int)(unsigned char)*str);
+            continue;
+        }
+        if (*str == '"' || *str == '\\') {
+            std::fputc('\\', file);
+        }
+        std::fputc(*str, file);
+    }
+}
+
+static void Push(ProfilerThreadBuffer* buffer, const ProfilerEvent& event)
+{
+    uint64_t count = buffer->Count.load(std::memory_order_relaxed);
+    buffer->Events[count & (ProfilerThreadBuffer::Capacity - 1)] = event;
+    buffer->Count.store(count + 1, std::memory_order_release);
+}
+
+void Profiler::Record(const char* name, uint64_t start, uint64_t end)
+{
+    ProfilerThreadBuffer* buffer = s_Buffer;
+    if (buffer == nullptr) {
+        buffer = _RegisterThread();
+    }
+    Push(buffer, ProfilerEvent {name, start, end, ProfilerEventType_Zone});
+}
+
+void Profiler::RecordCounter(const char* name, uint64_t value)
+{
+    ProfilerThreadBuffer* buffer = s_Buffer;
+    if (buffer == nullptr) {
+        buffer = _RegisterThread();
+    }
+    Push(buffer, ProfilerEvent {name, Time::NowNanoseconds(), value, ProfilerEventType_Counter});
+}
+
+void Profiler::SetThreadName(std::string_view name)
+{
+    ProfilerThreadBuffer* buffer = s_Buffer;
+    if (buffer == nullptr) {
+        buffer = _RegisterThread();
+    }
+
+    std::lock_guard<std::mutex> lock(s_BuffersMutex);
+    size_t size = std::min(name.size(), sizeof(buffer->ThreadName) - 1);
+    std::copy_n(name.data(), size, buffer->ThreadName);
+    buffer->ThreadName[size] = '\0';
+}
+
+bool Profiler::WriteChromeTrace(std::string_view path)
+{
+    std::FILE* file = std::fopen(std::string(path).c_str(), "wb");
+    CONTEXT_CONDITION_ERROR_RETURN("PROFILER", file != nullptr, false,
+                                   "Failed to open '{}' to write trace", path);
+
+    std::unique_lock<std::mutex> lock(s_BuffersMutex);
+    uint64_t origin = UINT64_MAX;
+    for (const std::unique_ptr<ProfilerThreadBuffer>& buffer : s_Buffers) {
+        uint64_t count = buffer->Count.load(std::memory_order_acquire);
+        uint64_t first = count > ProfilerThreadBuffer::Capacity
+                             ? count - ProfilerThreadBuffer::Capacity
+                             : 0;
+        for (uint64_t i = first; i < count; i++) {
+            const ProfilerEvent& event = buffer->Events[i & (ProfilerThreadBuffer::Capacity - 1)];
+            origin                     = std::min(origin, event.Start);
+        }
+    }
+
+    size_t written = 0;
+    std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+    for (const std::unique_ptr<ProfilerThreadBuffer>& buffer : s_Buffers) {
+        std::fprintf(file,
+                     "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,"
+                     "\"args\":{\"name\":\"",
+                     written++ > 0 ? "," : "", buffer->ThreadId);
+        WriteEscaped(file, buffer->ThreadName);
+        std::fputs("\"}}", file);
+
+        uint64_t count = buffer->Count.load(std::memory_order_acquire);
+        uint64_t first = count > ProfilerThreadBuffer::Capacity
+                             ? count - ProfilerThreadBuffer::Capacity
+                             : 0;
+        for (uint64_t i = first; i < count; i++) {
+            const ProfilerEvent& event = buffer->Events[i & (ProfilerThreadBuffer::Capacity - 1)];
+            std::fputs(",\n{\"name\":\"", file);
+            WriteEscaped(file, event.Name);
+            if (event.Type == ProfilerEventType_Counter) {
+                std::fprintf(file,
+                             "\",\"ph\":\"C\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,"
+                             "\"args\":{\"value\":%llu}}",
+                             buffer->ThreadId, (double)(event.Start - origin) * 1e-3,
+                             (unsigned long long)event.End);
+                continue;
+            }
+            std::fprintf(file, "\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                         buffer->ThreadId, (double)(event.Start - origin) * 1e-3,
+                         (double)(event.End - event.Start) * 1e-3);
+        }
+    }
+    size_t thread_count = s_Buffers.size();
+    lock.unlock();
+    std::fputs("\n]}\n", file);
+    std::fclose(file);
+
+    // Logging opens a profile zone, which takes the buffers lock to register a new thread
+    CONTEXT_INFO("PROFILER", "Wrote trace of {} threads to '{}'", thread_count, path);
+    return true;
+}
+
+ProfilerThreadBuffer* Profiler::_RegisterThread()
+{
+    std::unique_ptr<ProfilerThreadBuffer> buffer = std::make_unique<ProfilerThreadBuffer>();
+    buffer->Events = std::make_unique<ProfilerEvent[]>(ProfilerThreadBuffer::Capacity);
+
+    std::lock_guard<std::mutex> lock(s_BuffersMutex);
+    buffer->ThreadId = (uint32_t)s_Buffers.size();
+    std::snprintf(buffer->ThreadName, sizeof(buffer->ThreadName), "Thread %u", buffer->ThreadId);
+    s_Buffer = buffer.get();
+    s_Buffers.push_back(std::move(buffer));
+    return s_Buffer;
+}
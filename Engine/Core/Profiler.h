@@ -0,0 +1,96 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "Core/Time.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+// Zones are only compiled in when KryosRuntime is configured with KRYOS_PROFILE=ON, otherwise
+// every PROFILE_ macro expands to nothing
+#ifdef KRYOS_PROFILE
+#    define INTERNAL_PROFILE_CONCAT_IMPL(_a, _b) _a##_b
+#    define INTERNAL_PROFILE_CONCAT(_a, _b) INTERNAL_PROFILE_CONCAT_IMPL(_a, _b)
+#    define PROFILE_SCOPE(_name)                                                                  \
+        ProfilerScope INTERNAL_PROFILE_CONCAT(internal_profiler_scope_, __LINE__)(_name)
+#    define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#    define PROFILE_COUNTER(_name, _value) Profiler::RecordCounter(_name, (uint64_t)(_value))
+#    define PROFILE_THREAD_NAME(_name) Profiler::SetThreadName(_name)
+#    define PROFILE_WRITE_TRACE(_path) Profiler::WriteChromeTrace(_path)
+#else
+#    define PROFILE_SCOPE(_name) ((void)0)
+#    define PROFILE_FUNCTION() ((void)0)
+#    define PROFILE_COUNTER(_name, _value) ((void)0)
+#    define PROFILE_THREAD_NAME(_name) ((void)0)
+#    define PROFILE_WRITE_TRACE(_path) ((void)0)
+#endif
+
+enum ProfilerEventType : uint8_t {
+    ProfilerEventType_Zone,
+    ProfilerEventType_Counter,
+};
+
+struct ProfilerEvent {
+    const char* Name;
+    uint64_t Start;
+    uint64_t End; // Sampled value for counters
+    ProfilerEventType Type;
+};
+
+// Owned and written by a single thread, the exporter only reads up to the published Count. Once
+// full the oldest zones are overwritten so a trace always holds the most recent frames
+struct ProfilerThreadBuffer {
+    static constexpr size_t Capacity = 1 << 16;
+
+    std::unique_ptr<ProfilerEvent[]> Events;
+    std::atomic<uint64_t> Count = 0;
+    uint32_t ThreadId           = 0;
+    char ThreadName[32]         = {};
+};
+
+struct Profiler {
+    static void Record(const char* name, uint64_t start, uint64_t end);
+    static void RecordCounter(const char* name, uint64_t value);
+    static void SetThreadName(std::string_view name);
+
+    // Writes every recorded zone as a Chrome trace event file, viewable in about:tracing or
+    // ui.perfetto.dev. Best called once threads are idle, zones written while exporting may be
+    // missing from the trace
+    static bool WriteChromeTrace(std::string_view path);
+
+private:
+    static ProfilerThreadBuffer* _RegisterThread();
+};
+
+struct ProfilerScope {
+    const char* Name;
+    uint64_t Start;
+
+    inline ProfilerScope(const char* name)
+        : Name(name), Start(Time::NowNanoseconds())
+    {
+    }
+
+    inline ~ProfilerScope()
+    {
+        Profiler::Record(Name, Start, Time::NowNanoseconds());
+    }
+
+    ProfilerScope(const ProfilerScope&)            = delete;
+    ProfilerScope& operator=(const ProfilerScope&) = delete;
+};
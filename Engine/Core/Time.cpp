@@ -0,0 +1,213 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Core/Time.h"
+#include "Core/Console.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#    define KRYOS_TIME_TSC
+#    ifdef _MSC_VER
+#        include <intrin.h>
+#    else
+#        include <cpuid.h>
+#        include <x86intrin.h>
+#    endif
+#endif
+
+static Time* s_InstancePtr = nullptr;
+
+static bool s_UseTsc         = false;
+static uint64_t s_TscBase    = 0;
+static uint64_t s_TscBaseNs  = 0;
+static double s_NanosPerTick = 0.0;
+
+static uint64_t SteadyNanoseconds()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+#ifdef KRYOS_TIME_TSC
+static bool InvariantTscSupported()
+{
+    unsigned int regs[4] = {};
+#    ifdef _MSC_VER
+    __cpuid((int*)regs, 0x80000000);
+    if (regs[0] < 0x80000007) {
+        return false;
+    }
+    __cpuid((int*)regs, 0x80000007);
+#    else
+    if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007) {
+        return false;
+    }
+    __get_cpuid(0x80000007, &regs[0], &regs[1], &regs[2], &regs[3]);
+#    endif
+    return (regs[3] & (1 << 8)) != 0;
+}
+#endif
+
+uint64_t Time::NowNanoseconds()
+{
+#ifdef KRYOS_TIME_TSC
+    if (s_UseTsc) {
+        return s_TscBaseNs + (uint64_t)((double)(__rdtsc() - s_TscBase) * s_NanosPerTick);
+    }
+#endif
+    return SteadyNanoseconds();
+}
+
+void Time::CalibrateClock()
+{
+#ifdef KRYOS_TIME_TSC
+    if (!InvariantTscSupported()) {
+        CONTEXT_INFO("TIME", "No invariant TSC, using the steady clock");
+        return;
+    }
+
+    // Measure the TSC rate against the steady clock over a short window
+    uint64_t start_ns  = SteadyNanoseconds();
+    uint64_t start_tsc = __rdtsc();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    uint64_t end_ns  = SteadyNanoseconds();
+    uint64_t end_tsc = __rdtsc();
+    if (end_tsc <= start_tsc || end_ns <= start_ns) {
+        return;
+    }
+
+    s_NanosPerTick = (double)(end_ns - start_ns) / (double)(end_tsc - start_tsc);
+    s_TscBase      = end_tsc;
+    s_TscBaseNs    = end_ns;
+    s_UseTsc       = true;
+    CONTEXT_INFO("TIME", "Using invariant TSC at {:.3f} GHz", 1.0 / s_NanosPerTick);
+#endif
+}
+
+void Time::Initialize()
+{
+    s_InstancePtr = this;
+    CalibrateClock();
+
+    StartNanoseconds    = NowNanoseconds();
+    FrameNanoseconds    = StartNanoseconds;
+    FrameCount          = 0;
+    DeltaTime           = 0.0;
+    UnscaledDeltaTime   = 0.0;
+    ElapsedTime         = 0.0;
+    UnscaledElapsedTime = 0.0;
+    FixedAccumulator    = 0.0;
+    FrameHistoryCount   = 0;
+    FrameHistoryHead    = 0;
+}
+
+void Time::Update()
+{
+    uint64_t now          = NowNanoseconds();
+    double measured_delta = (double)(now - FrameNanoseconds) * 1e-9;
+    _Advance(now, measured_delta, measured_delta);
+}
+
+void Time::Update(double unscaled_delta)
+{
+    uint64_t now = NowNanoseconds();
+    _Advance(now, unscaled_delta, (double)(now - FrameNanoseconds) * 1e-9);
+}
+
+void Time::_Advance(uint64_t now, double unscaled_delta, double measured_delta)
+{
+    FrameNanoseconds  = now;
+    UnscaledDeltaTime = unscaled_delta;
+    UnscaledElapsedTime += unscaled_delta;
+    FrameCount++;
+
+    DeltaTime = std::min(UnscaledDeltaTime, MaxDeltaTime) * TimeScale;
+    ElapsedTime += DeltaTime;
+
+    FixedStepsThisFrame = 0;
+    FixedAccumulator    = std::min(FixedAccumulator + DeltaTime, FixedDeltaTime * MaxFixedSteps);
+
+    FrameHistory[FrameHistoryHead] = (float)(measured_delta * 1000.0);
+    FrameHistoryHead               = (FrameHistoryHead + 1) % FrameHistorySize;
+    FrameHistoryCount              = std::min(FrameHistoryCount + 1, FrameHistorySize);
+}
+
+bool Time::FixedStep()
+{
+    if (FixedStepsThisFrame >= MaxFixedSteps || FixedAccumulator < FixedDeltaTime) {
+        return false;
+    }
+    FixedAccumulator -= FixedDeltaTime;
+    FixedStepsThisFrame++;
+    return true;
+}
+
+FrameTimeStats Time::FrameStats()
+{
+    FrameTimeStats stats;
+    if (FrameHistoryCount == 0) {
+        return stats;
+    }
+
+    float* begin = FrameScratch.data();
+    float* end   = begin + FrameHistoryCount;
+    std::copy(FrameHistory.begin(), FrameHistory.begin() + FrameHistoryCount, begin);
+
+    float total = 0.0f;
+    for (float* it = begin; it != end; it++) {
+        total += *it;
+    }
+    stats.Average = total / (float)FrameHistoryCount;
+
+    // Each nth_element only has to partition the range above the previous percentile
+    auto percentile = [&](float* from, float fraction) {
+        float* nth = begin + (size_t)(fraction * (float)(FrameHistoryCount - 1) + 0.5f);
+        std::nth_element(from, nth, end);
+        return nth;
+    };
+    float* p50 = percentile(begin, 0.50f);
+    float* p95 = percentile(p50, 0.95f);
+    float* p99 = percentile(p95, 0.99f);
+    stats.P50  = *p50;
+    stats.P95  = *p95;
+    stats.P99  = *p99;
+
+    stats.Minimum = *std::min_element(begin, p50 + 1);
+    stats.Maximum = *std::max_element(p99, end);
+    return stats;
+}
+
+double Time::Delta()
+{
+    return s_InstancePtr->DeltaTime;
+}
+
+double Time::UnscaledDelta()
+{
+    return s_InstancePtr->UnscaledDeltaTime;
+}
+
+double Time::Elapsed()
+{
+    return s_InstancePtr->ElapsedTime;
+}
+
+double Time::FixedDelta()
+{
+    return s_InstancePtr->FixedDeltaTime;
+}
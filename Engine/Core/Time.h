@@ -0,0 +1,84 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+struct FrameTimeStats {
+    // Milliseconds over the frames currently in Time::FrameHistory
+    float Average = 0.0f;
+    float Minimum = 0.0f;
+    float Maximum = 0.0f;
+    float P50     = 0.0f;
+    float P95     = 0.0f;
+    float P99     = 0.0f;
+};
+
+struct Time {
+    static constexpr size_t FrameHistorySize = 256;
+
+    uint64_t StartNanoseconds = 0;
+    uint64_t FrameNanoseconds = 0; // Timestamp taken by the last Update
+    uint64_t FrameCount       = 0;
+
+    double TimeScale           = 1.0;
+    double MaxDeltaTime        = 0.25; // Scaled delta is clamped to this after hitches
+    double DeltaTime           = 0.0;
+    double UnscaledDeltaTime   = 0.0;
+    double ElapsedTime         = 0.0;
+    double UnscaledElapsedTime = 0.0;
+
+    double FixedDeltaTime        = 1.0 / 60.0;
+    double FixedAccumulator      = 0.0;
+    uint32_t MaxFixedSteps       = 8; // Backlog past this many steps per frame is dropped
+    uint32_t FixedStepsThisFrame = 0;
+
+    std::array<float, FrameHistorySize> FrameHistory; // Ring of frame times in milliseconds
+    std::array<float, FrameHistorySize> FrameScratch; // Reused when computing FrameStats
+    size_t FrameHistoryCount = 0;
+    size_t FrameHistoryHead  = 0;
+
+    void Initialize();
+
+    // Call once at the start of every frame
+    void Update();
+    // Uses unscaled_delta in place of the measured delta, e.g. when replaying recorded input.
+    // FrameHistory still records the measured frame time
+    void Update(double unscaled_delta);
+
+    // Consumes one fixed step from the accumulator, use as `while (time.FixedStep()) {}`
+    bool FixedStep();
+
+    // How far between the last and next fixed step the current frame is, for interpolation
+    inline double FixedAlpha() const { return FixedAccumulator / FixedDeltaTime; }
+
+    FrameTimeStats FrameStats();
+
+    // Monotonic clock, uses the calibrated invariant TSC on x86 when available and the
+    // steady clock otherwise
+    static uint64_t NowNanoseconds();
+    static void CalibrateClock();
+
+    static double Delta();
+    static double UnscaledDelta();
+    static double Elapsed();
+    static double FixedDelta();
+
+private:
+    void _Advance(uint64_t now, double unscaled_delta, double measured_delta);
+};
@@ -0,0 +1,119 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "RHI/CommandBuffer.h"
+#include "Core/JobSystem.h"
+#include "Core/Profiler.h"
+#include <algorithm>
+
+void RenderCommandBuffer::BindBuffer(RenderBufferTarget target, RenderHandle buffer, uint16_t slot,
+                                     uint64_t offset, uint64_t size)
+{
+    Push(RenderCommandBindBuffer {
+        .Target = target,
+        .Slot   = slot,
+        .Buffer = buffer,
+        .Offset = offset,
+        .Size   = size,
+        .Stride = 0,
+    });
+}
+
+void RenderCommandBuffer::BindVertexBuffer(uint16_t slot, RenderHandle buffer, uint32_t stride,
+                                           uint64_t offset)
+{
+    Push(RenderCommandBindBuffer {
+        .Target = RenderBufferTarget_Vertex,
+        .Slot   = slot,
+        .Buffer = buffer,
+        .Offset = offset,
+        .Size   = 0,
+        .Stride = stride,
+    });
+}
+
+void RenderCommandBuffer::Draw(uint32_t vertex_count, uint32_t instance_count,
+                               uint32_t first_vertex, uint32_t first_instance)
+{
+    Push(RenderCommandDraw {
+        .VertexCount   = vertex_count,
+        .InstanceCount = instance_count,
+        .FirstVertex   = first_vertex,
+        .FirstInstance = first_instance,
+    });
+}
+
+void RenderCommandBuffer::DrawIndexed(uint32_t index_count, uint32_t instance_count,
+                                      uint32_t first_index, int32_t base_vertex,
+                                      uint32_t first_instance, RenderIndexType index_type)
+{
+    Push(RenderCommandDrawIndexed {
+        .IndexCount    = index_count,
+        .InstanceCount = instance_count,
+        .FirstIndex    = first_index,
+        .BaseVertex    = base_vertex,
+        .FirstInstance = first_instance,
+        .IndexType     = index_type,
+    });
+}
+
+void RenderCommandBuffer::DrawIndexedIndirect(uint64_t offset, uint32_t draw_count,
+                                              uint32_t stride, RenderIndexType index_type)
+{
+    Push(RenderCommandDrawIndexedIndirect {
+        .Offset    = offset,
+        .DrawCount = draw_count,
+        .Stride    = stride,
+        .IndexType = index_type,
+    });
+}
+
+void RenderCommandBuffer::Dispatch(uint32_t groups_x, uint32_t groups_y, uint32_t groups_z)
+{
+    Push(RenderCommandDispatch {
+        .GroupsX = groups_x,
+        .GroupsY = groups_y,
+        .GroupsZ = groups_z,
+    });
+}
+
+void RenderCommandQueue::Initialize(uint32_t buffer_count)
+{
+    Buffers.resize(std::max(buffer_count, 1u));
+    Reset();
+}
+
+void RenderCommandQueue::Reset()
+{
+    for (RenderCommandBuffer& buffer : Buffers) {
+        buffer.Reset();
+    }
+}
+
+void RenderCommandQueue::Execute()
+{
+    PROFILE_SCOPE("RenderCommandQueue::Execute");
+    ExecutedCount = 0;
+    for (const RenderCommandBuffer& buffer : Buffers) {
+        ExecutedCount += buffer.Execute();
+    }
+}
+
+RenderCommandBuffer& RenderCommandQueue::Local()
+{
+    // Threads outside the job system share the last buffer
+    uint32_t index = std::min(JobSystem::CurrentWorkerIndex(), (uint32_t)Buffers.size() - 1);
+    return Buffers[index];
+}
@@ -0,0 +1,191 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+using RenderHandle = uint32_t; // Backend object name, e.g. a GL program or buffer
+
+enum RenderCommandType : uint16_t {
+    RenderCommandType_BindPipeline,
+    RenderCommandType_BindVertexArray,
+    RenderCommandType_BindBuffer,
+    RenderCommandType_Draw,
+    RenderCommandType_DrawIndexed,
+    RenderCommandType_DrawIndexedIndirect,
+    RenderCommandType_Dispatch,
+};
+
+enum RenderBufferTarget : uint16_t {
+    RenderBufferTarget_Vertex,
+    RenderBufferTarget_Index,
+    RenderBufferTarget_Uniform,
+    RenderBufferTarget_Storage,
+    RenderBufferTarget_Indirect,
+};
+
+enum RenderIndexType : uint16_t {
+    RenderIndexType_U16,
+    RenderIndexType_U32,
+};
+
+// Draws use triangle lists until pipelines carry their own topology
+
+// Packets are written back to back into a RenderCommandBuffer, each starting with this header
+struct RenderCommandHeader {
+    static constexpr size_t PayloadOffset = 8; // Keeps every payload 8 byte aligned
+
+    RenderCommandType Type;
+    uint16_t Size; // Including the header and padding
+};
+
+struct RenderCommandBindPipeline {
+    static constexpr RenderCommandType Type = RenderCommandType_BindPipeline;
+    RenderHandle Program;
+};
+
+struct RenderCommandBindVertexArray {
+    static constexpr RenderCommandType Type = RenderCommandType_BindVertexArray;
+    RenderHandle VertexArray;
+};
+
+struct RenderCommandBindBuffer {
+    static constexpr RenderCommandType Type = RenderCommandType_BindBuffer;
+    RenderBufferTarget Target;
+    uint16_t Slot; // Binding point for vertex, uniform and storage buffers
+    RenderHandle Buffer;
+    uint64_t Offset;
+    uint64_t Size;   // 0 binds the whole buffer
+    uint32_t Stride; // Vertex buffers only
+};
+
+struct RenderCommandDraw {
+    static constexpr RenderCommandType Type = RenderCommandType_Draw;
+    uint32_t VertexCount;
+    uint32_t InstanceCount;
+    uint32_t FirstVertex;
+    uint32_t FirstInstance;
+};
+
+struct RenderCommandDrawIndexed {
+    static constexpr RenderCommandType Type = RenderCommandType_DrawIndexed;
+    uint32_t IndexCount;
+    uint32_t InstanceCount;
+    uint32_t FirstIndex;
+    int32_t BaseVertex;
+    uint32_t FirstInstance;
+    RenderIndexType IndexType;
+};
+
+// Reads draw_count RenderDrawIndexedIndirectArgs from the bound indirect buffer, so any number of
+// draws sharing the same bindings are a single call
+struct RenderCommandDrawIndexedIndirect {
+    static constexpr RenderCommandType Type = RenderCommandType_DrawIndexedIndirect;
+    uint64_t Offset; // Into the indirect buffer, 4 byte aligned
+    uint32_t DrawCount;
+    uint32_t Stride; // 0 when the arguments are tightly packed
+    RenderIndexType IndexType;
+};
+
+struct RenderCommandDispatch {
+    static constexpr RenderCommandType Type = RenderCommandType_Dispatch;
+    uint32_t GroupsX;
+    uint32_t GroupsY;
+    uint32_t GroupsZ;
+};
+
+// Arguments of one indirect draw as the GPU reads them, matches GL's DrawElementsIndirectCommand
+struct RenderDrawIndexedIndirectArgs {
+    uint32_t IndexCount;
+    uint32_t InstanceCount;
+    uint32_t FirstIndex;
+    int32_t BaseVertex;
+    uint32_t FirstInstance;
+};
+
+// Linear buffer of command packets recorded by a single thread. Memory is kept between frames
+// so recording stops allocating once the buffer has grown to fit a typical frame
+struct RenderCommandBuffer {
+    std::vector<uint8_t> Data;
+    uint32_t CommandCount = 0;
+
+    inline void Reset()
+    {
+        Data.clear();
+        CommandCount = 0;
+    }
+
+    template <typename TCommand>
+    void Push(const TCommand& command);
+
+    inline void BindPipeline(RenderHandle program) { Push(RenderCommandBindPipeline {program}); }
+    inline void BindVertexArray(RenderHandle vao) { Push(RenderCommandBindVertexArray {vao}); }
+    void BindBuffer(RenderBufferTarget target, RenderHandle buffer, uint16_t slot = 0,
+                    uint64_t offset = 0, uint64_t size = 0);
+    void BindVertexBuffer(uint16_t slot, RenderHandle buffer, uint32_t stride,
+                          uint64_t offset = 0);
+    void Draw(uint32_t vertex_count, uint32_t instance_count = 1, uint32_t first_vertex = 0,
+              uint32_t first_instance = 0);
+    void DrawIndexed(uint32_t index_count, uint32_t instance_count = 1, uint32_t first_index = 0,
+                     int32_t base_vertex = 0, uint32_t first_instance = 0,
+                     RenderIndexType index_type = RenderIndexType_U32);
+    void DrawIndexedIndirect(uint64_t offset, uint32_t draw_count, uint32_t stride = 0,
+                             RenderIndexType index_type = RenderIndexType_U32);
+    void Dispatch(uint32_t groups_x, uint32_t groups_y = 1, uint32_t groups_z = 1);
+
+    // Replays the packets through the active backend, returns the number of commands executed
+    uint32_t Execute() const;
+};
+
+// One RenderCommandBuffer per job worker plus one for a thread outside the job system (e.g. the
+// render thread), so recording from jobs never contends. Execute replays every buffer in worker
+// order on the thread that owns the graphics context
+struct RenderCommandQueue {
+    std::vector<RenderCommandBuffer> Buffers;
+    uint32_t ExecutedCount = 0; // Commands replayed by the last Execute
+
+    // buffer_count is normally JobSystem::WorkerCount() + 1
+    void Initialize(uint32_t buffer_count);
+    void Reset();
+
+    // Buffer of the calling thread, fetch it again after JobSystem::Wait as fiber jobs may
+    // resume on another worker
+    RenderCommandBuffer& Local();
+
+    void Execute();
+};
+
+template <typename TCommand>
+void RenderCommandBuffer::Push(const TCommand& command)
+{
+    static_assert(std::is_trivially_copyable_v<TCommand>, "Render commands are copied byte wise");
+    static_assert(alignof(TCommand) <= 8, "Render commands are packed on 8 byte boundaries");
+
+    constexpr size_t size =
+        (RenderCommandHeader::PayloadOffset + sizeof(TCommand) + 7) & ~(size_t)7;
+
+    size_t offset = Data.size();
+    Data.resize(offset + size);
+
+    RenderCommandHeader header {TCommand::Type, (uint16_t)size};
+    std::memcpy(Data.data() + offset, &header, sizeof(header));
+    std::memcpy(Data.data() + offset + RenderCommandHeader::PayloadOffset, &command,
+                sizeof(TCommand));
+    CommandCount++;
+}
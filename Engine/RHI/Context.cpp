@@ -19,7 +19,8 @@ void RenderHardwareContext::Initialize(const std::string_view& title, int width,
                                        int flags)
 {
     Window.InitializeGLFW();
-    Window.Initialize("Kryos Engine", -1, -1);
+    Window.Initialize(title, width, height, flags);
+    InitializeRHI();
 }
 
 void RenderHardwareContext::Destroy()
@@ -16,8 +16,15 @@
 #pragma once
 
 #include "RHI/WindowHandle.h"
+#include <cstdint>
 #include <string_view>
 
+// Redundant state changes filtered out by the backend since InitializeRHI
+struct RenderStateCounters {
+    uint64_t Issued;
+    uint64_t Skipped;
+};
+
 struct RenderHardwareContext {
     WindowHandle Window;
 
@@ -25,4 +32,6 @@ struct RenderHardwareContext {
                     int flags = WindowHandle::DefaultFlags);
     void InitializeRHI();
     void Destroy();
+
+    RenderStateCounters StateCounters() const;
 };
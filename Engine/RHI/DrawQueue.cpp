@@ -0,0 +1,155 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "RHI/DrawQueue.h"
+#include "Core/JobSystem.h"
+#include "Core/Profiler.h"
+#include "Core/Time.h"
+#include <algorithm>
+
+uint64_t RenderSortKey::Make(uint32_t layer, uint32_t pass, bool translucent, uint32_t shader,
+                             uint32_t material, float depth)
+{
+    constexpr uint64_t depth_max = (1ull << DepthBits) - 1;
+
+    uint64_t quantized   = (uint64_t)(std::clamp(depth, 0.0f, 1.0f) * (float)depth_max);
+    uint64_t shader_id   = shader & ((1u << ShaderBits) - 1);
+    uint64_t material_id = material & ((1u << MaterialBits) - 1);
+
+    uint64_t key = (uint64_t)(layer & 0xF) << 60 | (uint64_t)(pass & 0xF) << 56;
+    if (translucent) {
+        key |= 1ull << 55;
+        key |= (depth_max - quantized) << 31 | shader_id << 19 | material_id << 3;
+    }
+    else {
+        key |= shader_id << 43 | material_id << 27 | quantized << 3;
+    }
+    return key;
+}
+
+void RadixSort(RenderSortItem* items, RenderSortItem* scratch, size_t count)
+{
+    // Histograms for all 8 digits are built in a single read of the keys
+    uint32_t histograms[8][256] = {};
+    for (size_t i = 0; i < count; i++) {
+        uint64_t key = items[i].Key;
+        for (uint32_t digit = 0; digit < 8; digit++) {
+            histograms[digit][(key >> (digit * 8)) & 0xFF]++;
+        }
+    }
+
+    RenderSortItem* src = items;
+    RenderSortItem* dst = scratch;
+    for (uint32_t digit = 0; digit < 8; digit++) {
+        uint32_t* histogram = histograms[digit];
+        uint32_t shift      = digit * 8;
+        if (count == 0 || histogram[(src[0].Key >> shift) & 0xFF] == count) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t bin = 0; bin < 256; bin++) {
+            uint32_t bin_count = histogram[bin];
+            histogram[bin]     = offset;
+            offset += bin_count;
+        }
+        for (size_t i = 0; i < count; i++) {
+            dst[histogram[(src[i].Key >> shift) & 0xFF]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != items) {
+        std::copy(src, src + count, items);
+    }
+}
+
+void RenderDrawQueue::Initialize(uint32_t bucket_count)
+{
+    Buckets.resize(std::max(bucket_count, 1u));
+    Reset();
+}
+
+void RenderDrawQueue::Reset()
+{
+    for (RenderDrawBucket& bucket : Buckets) {
+        bucket.Keys.clear();
+        bucket.Draws.clear();
+    }
+    Commands.Reset();
+}
+
+RenderDrawBucket& RenderDrawQueue::Local()
+{
+    uint32_t index = std::min(JobSystem::CurrentWorkerIndex(), (uint32_t)Buckets.size() - 1);
+    return Buckets[index];
+}
+
+void RenderDrawQueue::Build(bool sort)
+{
+    PROFILE_SCOPE("RenderDrawQueue::Build");
+    Items.clear();
+    for (uint32_t bucket = 0; bucket < Buckets.size(); bucket++) {
+        const std::vector<uint64_t>& keys = Buckets[bucket].Keys;
+        for (uint32_t i = 0; i < keys.size(); i++) {
+            Items.push_back(RenderSortItem {keys[i], bucket, i});
+        }
+    }
+    DrawCount = (uint32_t)Items.size();
+
+    uint64_t sort_start = Time::NowNanoseconds();
+    if (sort) {
+        Scratch.resize(Items.size());
+        RadixSort(Items.data(), Scratch.data(), Items.size());
+    }
+    SortNanoseconds = Time::NowNanoseconds() - sort_start;
+
+    Commands.Reset();
+    StateChanges = 0;
+
+    // 0 is never a valid GL object name, so the first draw always binds. The material slot
+    // starts out unknown instead, as 0 is what a draw without a material binds
+    RenderHandle program      = 0;
+    RenderHandle vertex_array = 0;
+    RenderHandle material     = ~(RenderHandle)0;
+    for (const RenderSortItem& item : Items) {
+        const RenderDraw& draw = Buckets[item.Bucket].Draws[item.Index];
+        if (draw.Program != program) {
+            program = draw.Program;
+            Commands.BindPipeline(program);
+            StateChanges++;
+        }
+        if (draw.VertexArray != vertex_array) {
+            vertex_array = draw.VertexArray;
+            Commands.BindVertexArray(vertex_array);
+            StateChanges++;
+        }
+        if (draw.Material != material) {
+            // Material 0 unbinds the slot, so such a draw never sees the previous draw's buffer
+            material = draw.Material;
+            Commands.BindBuffer(RenderBufferTarget_Uniform, material, MaterialSlot);
+            StateChanges++;
+        }
+        Commands.DrawIndexed(draw.IndexCount, draw.InstanceCount, draw.FirstIndex,
+                             draw.BaseVertex, draw.FirstInstance, draw.IndexType);
+    }
+}
+
+void RenderDrawQueue::Execute()
+{
+    PROFILE_SCOPE("RenderDrawQueue::Execute");
+    Build();
+    Commands.Execute();
+}
@@ -0,0 +1,106 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "RHI/CommandBuffer.h"
+
+// 64 bit draw sort key, most significant bits first:
+//
+//   63..60 layer | 59..56 pass | 55 translucent | 54..0 depends on translucency
+//   opaque:      54..43 shader | 42..27 material | 26..3 depth, near to far
+//   translucent: 54..31 depth, far to near | 30..19 shader | 18..3 material
+//
+// Opaque draws group by shader then material to minimize state changes and use depth only to
+// break ties, translucent draws must blend in order so depth comes first
+struct RenderSortKey {
+    static constexpr uint32_t LayerBits    = 4;
+    static constexpr uint32_t PassBits     = 4;
+    static constexpr uint32_t ShaderBits   = 12;
+    static constexpr uint32_t MaterialBits = 16;
+    static constexpr uint32_t DepthBits    = 24;
+
+    // depth is normalized to 0..1 between the near and far plane, values outside are clamped
+    static uint64_t Make(uint32_t layer, uint32_t pass, bool translucent, uint32_t shader,
+                         uint32_t material, float depth);
+
+    static inline uint32_t Layer(uint64_t key) { return (uint32_t)(key >> 60); }
+    static inline uint32_t Pass(uint64_t key) { return (uint32_t)(key >> 56) & 0xF; }
+    static inline bool Translucent(uint64_t key) { return (key >> 55) & 1; }
+};
+
+struct RenderDraw {
+    RenderHandle Program;
+    RenderHandle VertexArray;
+    RenderHandle Material; // Uniform buffer at RenderDrawQueue::MaterialSlot, 0 unbinds it
+    uint32_t IndexCount;
+    uint32_t FirstIndex;
+    int32_t BaseVertex;
+    uint32_t InstanceCount;
+    uint32_t FirstInstance;
+    RenderIndexType IndexType;
+};
+
+struct RenderSortItem {
+    uint64_t Key;
+    uint32_t Bucket;
+    uint32_t Index;
+};
+
+// Stable least significant digit radix sort on RenderSortItem::Key, 8 bits per pass. Passes
+// where every key shares the same digit are skipped, which is common as layer and pass bits
+// rarely vary. scratch must hold count items, the result is always written back to items
+void RadixSort(RenderSortItem* items, RenderSortItem* scratch, size_t count);
+
+// Draws submitted by a single thread, indexed alongside their sort keys
+struct RenderDrawBucket {
+    std::vector<uint64_t> Keys;
+    std::vector<RenderDraw> Draws;
+
+    inline void Submit(uint64_t key, const RenderDraw& draw)
+    {
+        Keys.push_back(key);
+        Draws.push_back(draw);
+    }
+};
+
+// Per worker draw submission that is merged, sorted by key and turned into a single command
+// buffer, only binding the program, vertex array and material when they differ from the
+// previous draw
+struct RenderDrawQueue {
+    static constexpr uint16_t MaterialSlot = 0;
+
+    std::vector<RenderDrawBucket> Buckets;
+    std::vector<RenderSortItem> Items;
+    std::vector<RenderSortItem> Scratch;
+    RenderCommandBuffer Commands; // Output of the last Build
+
+    uint32_t DrawCount       = 0;
+    uint32_t StateChanges    = 0; // Binds emitted by the last Build
+    uint64_t SortNanoseconds = 0;
+
+    // bucket_count is normally JobSystem::WorkerCount() + 1
+    void Initialize(uint32_t bucket_count);
+    void Reset();
+
+    // Bucket of the calling thread, see RenderCommandQueue::Local
+    RenderDrawBucket& Local();
+
+    // sort = false keeps submission order, which is only useful to measure what sorting saves
+    void Build(bool sort = true);
+
+    // Builds the sorted command buffer and replays it
+    void Execute();
+};
@@ -0,0 +1,137 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "RHI/Shader.h"
+#include "Core/Console.h"
+#include "Core/Hash.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fmt/format.h>
+
+void ShaderCache::Initialize(std::string_view directory)
+{
+    Directory = directory;
+    HitCount  = 0;
+    MissCount = 0;
+    Enabled   = _QueryDriver();
+    if (!Enabled) {
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(Directory, error);
+    if (error) {
+        CONTEXT_WARN("SHADER", "Failed to create shader cache directory '{}': {}", Directory,
+                     error.message());
+        Enabled = false;
+    }
+}
+
+uint64_t ShaderCache::Key(const ShaderProgramDesc& desc) const
+{
+    uint64_t hash = HashBytes(&ShaderCacheHeader::Version, sizeof(uint32_t), DriverHash);
+    for (const ShaderStageSource& stage : desc.Stages) {
+        hash = HashBytes(&stage.Stage, sizeof(stage.Stage), hash);
+        hash = HashString(stage.Source, hash);
+    }
+    for (const ShaderDefine& define : desc.Defines) {
+        hash = HashString(define.Name, hash);
+        hash = HashString(define.Value, hash);
+    }
+    return hash;
+}
+
+std::string ShaderCache::Path(uint64_t key) const
+{
+    return fmt::format("{}/{:016x}.bin", Directory, key);
+}
+
+bool ShaderCache::Load(uint64_t key, uint32_t& format, std::vector<uint8_t>& binary) const
+{
+    std::FILE* file = std::fopen(Path(key).c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    ShaderCacheHeader header;
+    bool valid = std::fread(&header, sizeof(header), 1, file) == 1 &&
+                 std::equal(header.FileMagic, header.FileMagic + 8, ShaderCacheHeader::Magic) &&
+                 header.FileVersion == ShaderCacheHeader::Version && header.Key == key;
+    if (valid) {
+        binary.resize(header.Size);
+        valid  = std::fread(binary.data(), 1, binary.size(), file) == binary.size();
+        format = header.Format;
+    }
+    std::fclose(file);
+    return valid;
+}
+
+bool ShaderCache::Store(uint64_t key, uint32_t format, const std::vector<uint8_t>& binary) const
+{
+    // Written under a temporary name and renamed, so a crash never leaves a truncated entry
+    std::string path      = Path(key);
+    std::string temp_path = path + ".tmp";
+    std::FILE* file       = std::fopen(temp_path.c_str(), "wb");
+    CONTEXT_CONDITION_ERROR_RETURN("SHADER", file != nullptr, false,
+                                   "Failed to open '{}' to write shader binary", temp_path);
+
+    ShaderCacheHeader header {
+        .FileMagic   = {},
+        .FileVersion = ShaderCacheHeader::Version,
+        .Format      = format,
+        .Key         = key,
+        .Size        = binary.size(),
+    };
+    std::copy_n(ShaderCacheHeader::Magic, 8, header.FileMagic);
+
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   std::fwrite(binary.data(), 1, binary.size(), file) == binary.size();
+    std::fclose(file);
+
+    std::error_code error;
+    if (written) {
+        std::filesystem::rename(temp_path, path, error);
+    }
+    if (!written || error) {
+        std::filesystem::remove(temp_path, error);
+        CONTEXT_ERROR_RETURN("SHADER", false, "Failed to write shader binary '{}'", path);
+    }
+    return true;
+}
+
+std::string Shader::ComposeSource(std::string_view source,
+                                  const std::vector<ShaderDefine>& defines)
+{
+    size_t insert = 0;
+    if (source.substr(0, 8) == "#version") {
+        size_t line_end = source.find('\n');
+        insert          = line_end == std::string_view::npos ? source.size() : line_end + 1;
+    }
+
+    std::string composed(source.substr(0, insert));
+    if (insert > 0 && composed.back() != '\n') {
+        composed.push_back('\n');
+    }
+    for (const ShaderDefine& define : defines) {
+        fmt::format_to(std::back_inserter(composed), "#define {} {}\n", define.Name, define.Value);
+    }
+    if (!defines.empty()) {
+        // Keeps compiler diagnostics pointing at lines of the original source
+        fmt::format_to(std::back_inserter(composed), "#line {}\n", insert > 0 ? 2 : 1);
+    }
+    composed.append(source.substr(insert));
+    return composed;
+}
@@ -0,0 +1,94 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "RHI/CommandBuffer.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum ShaderStage : uint8_t {
+    ShaderStage_Vertex,
+    ShaderStage_Fragment,
+    ShaderStage_Geometry,
+    ShaderStage_Compute,
+};
+
+struct ShaderStageSource {
+    ShaderStage Stage;
+    std::string_view Source;
+};
+
+struct ShaderDefine {
+    std::string_view Name;
+    std::string_view Value;
+};
+
+struct ShaderProgramDesc {
+    std::string_view Name; // Only used for diagnostics
+    std::vector<ShaderStageSource> Stages;
+    std::vector<ShaderDefine> Defines;
+};
+
+// Binary header of every cache entry, entries whose header does not match are recompiled
+struct ShaderCacheHeader {
+    static constexpr char Magic[8]    = {'K', 'R', 'Y', 'O', 'S', 'S', 'H', 'B'};
+    static constexpr uint32_t Version = 1;
+
+    char FileMagic[8];
+    uint32_t FileVersion;
+    uint32_t Format; // Driver specific binary format, e.g. from glGetProgramBinary
+    uint64_t Key;
+    uint64_t Size;
+};
+
+// On-disk cache of linked program binaries, keyed by a hash of the stage sources, defines and
+// driver identification so that a driver update or any source change misses instead of loading
+// a stale binary
+struct ShaderCache {
+    std::string Directory;
+    uint64_t DriverHash = 0;
+    bool Enabled        = false; // False when the backend cannot retrieve program binaries
+    uint32_t HitCount   = 0;
+    uint32_t MissCount  = 0;
+
+    // Requires the graphics context to be current, to query the driver
+    void Initialize(std::string_view directory);
+
+    uint64_t Key(const ShaderProgramDesc& desc) const;
+    std::string Path(uint64_t key) const;
+    bool Load(uint64_t key, uint32_t& format, std::vector<uint8_t>& binary) const;
+    bool Store(uint64_t key, uint32_t format, const std::vector<uint8_t>& binary) const;
+
+private:
+    // Backend specific, hashes the driver identification and reports binary support
+    bool _QueryDriver();
+};
+
+struct Shader {
+    RenderHandle Program = 0;
+    uint64_t Key         = 0;
+    bool FromCache       = false;
+
+    // Compiles and links desc, or loads it from cache when one is given and holds a binary for it
+    bool Initialize(const ShaderProgramDesc& desc, ShaderCache* cache = nullptr);
+    void Destroy();
+
+    // Source for one stage with the defines inserted after its #version line
+    static std::string ComposeSource(std::string_view source,
+                                     const std::vector<ShaderDefine>& defines);
+};
@@ -0,0 +1,182 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "RHI/ShaderArchive.h"
+#include "Core/Console.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+bool ShaderArchive::Load(std::string_view path)
+{
+    Destroy();
+    std::FILE* file = std::fopen(std::string(path).c_str(), "rb");
+    CONTEXT_CONDITION_ERROR_RETURN("SHADER", file != nullptr, false,
+                                   "Failed to open shader archive '{}'", path);
+
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    Data.resize(size > 0 ? (size_t)size : 0);
+    bool read = std::fread(Data.data(), 1, Data.size(), file) == Data.size();
+    std::fclose(file);
+
+    if (read && Data.size() >= sizeof(ShaderArchiveHeader)) {
+        std::memcpy(&Header, Data.data(), sizeof(Header));
+    }
+    uint64_t tables = sizeof(ShaderArchiveHeader) +
+                      (uint64_t)Header.EntryCount * sizeof(ShaderArchiveEntry) +
+                      (uint64_t)Header.StageCount * sizeof(ShaderArchiveStage) +
+                      (uint64_t)Header.SourceCount * sizeof(ShaderArchiveSource);
+    bool valid = read && std::equal(Header.FileMagic, Header.FileMagic + 8,
+                                    ShaderArchiveHeader::Magic) &&
+                 Header.FileVersion == ShaderArchiveHeader::Version && tables <= Data.size();
+    if (!valid) {
+        Destroy();
+        CONTEXT_ERROR_RETURN("SHADER", false, "'{}' is not a valid shader archive", path);
+    }
+    return true;
+}
+
+void ShaderArchive::Destroy()
+{
+    Data.clear();
+    Data.shrink_to_fit();
+    Header = ShaderArchiveHeader {};
+}
+
+bool ShaderArchive::Find(uint64_t key, ShaderProgramDesc& desc) const
+{
+    const ShaderArchiveEntry* begin = _Entries();
+    const ShaderArchiveEntry* end   = begin + Header.EntryCount;
+    const ShaderArchiveEntry* entry = std::lower_bound(
+        begin, end, key, [](const ShaderArchiveEntry& a, uint64_t b) { return a.Key < b; });
+    if (entry == end || entry->Key != key) {
+        return false;
+    }
+
+    const ShaderArchiveStage* stages   = _Stages();
+    const ShaderArchiveSource* sources = _Sources();
+    size_t text_size                   = Data.size() - (_Text() - (const char*)Data.data());
+
+    desc.Stages.clear();
+    desc.Defines.clear();
+    for (uint32_t i = 0; i < entry->StageCount; i++) {
+        uint64_t stage_index = (uint64_t)entry->FirstStage + i;
+        bool in_bounds       = stage_index < Header.StageCount &&
+                         stages[stage_index].Source < Header.SourceCount;
+        CONTEXT_CONDITION_ERROR_RETURN("SHADER", in_bounds, false,
+                                       "Shader archive stage out of bounds");
+
+        const ShaderArchiveStage& stage   = stages[stage_index];
+        const ShaderArchiveSource& source = sources[stage.Source];
+        in_bounds = (uint64_t)source.Offset + source.Size <= text_size;
+        CONTEXT_CONDITION_ERROR_RETURN("SHADER", in_bounds, false,
+                                       "Shader archive source out of bounds");
+        desc.Stages.push_back(ShaderStageSource {
+            .Stage  = (ShaderStage)stage.Stage,
+            .Source = std::string_view(_Text() + source.Offset, source.Size),
+        });
+    }
+    return true;
+}
+
+int64_t ShaderArchive::Write(std::string_view path, std::vector<ShaderVariant>& variants)
+{
+    std::sort(variants.begin(), variants.end(),
+              [](const ShaderVariant& a, const ShaderVariant& b) { return a.Key < b.Key; });
+
+    std::vector<ShaderArchiveEntry> entries;
+    std::vector<ShaderArchiveStage> stages;
+    std::vector<ShaderArchiveSource> sources;
+    std::unordered_map<std::string_view, uint32_t> source_indices;
+    std::string text;
+
+    entries.reserve(variants.size());
+    for (const ShaderVariant& variant : variants) {
+        if (!entries.empty() && entries.back().Key == variant.Key) {
+            CONTEXT_ERROR_RETURN("SHADER", -1, "Shader variant key collision 0x{:016x}",
+                                 variant.Key);
+        }
+        entries.push_back(ShaderArchiveEntry {
+            .Key        = variant.Key,
+            .FirstStage = (uint32_t)stages.size(),
+            .StageCount = (uint32_t)variant.Stages.size(),
+        });
+
+        for (const ShaderSourceStage& stage : variant.Stages) {
+            auto [it, inserted] =
+                source_indices.try_emplace(stage.Source, (uint32_t)sources.size());
+            if (inserted) {
+                sources.push_back(ShaderArchiveSource {
+                    .Offset = (uint32_t)text.size(),
+                    .Size   = (uint32_t)stage.Source.size(),
+                });
+                text.append(stage.Source);
+            }
+            stages.push_back(ShaderArchiveStage {(uint32_t)stage.Stage, it->second});
+        }
+    }
+    CONTEXT_CONDITION_ERROR_RETURN("SHADER", text.size() <= UINT32_MAX, -1,
+                                   "Shader archive '{}' exceeds 4GB of source", path);
+
+    ShaderArchiveHeader header {
+        .FileMagic   = {},
+        .FileVersion = ShaderArchiveHeader::Version,
+        .EntryCount  = (uint32_t)entries.size(),
+        .StageCount  = (uint32_t)stages.size(),
+        .SourceCount = (uint32_t)sources.size(),
+    };
+    std::copy_n(ShaderArchiveHeader::Magic, 8, header.FileMagic);
+
+    std::FILE* file = std::fopen(std::string(path).c_str(), "wb");
+    CONTEXT_CONDITION_ERROR_RETURN("SHADER", file != nullptr, -1,
+                                   "Failed to open '{}' to write shader archive", path);
+    bool written =
+        std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+        std::fwrite(entries.data(), sizeof(ShaderArchiveEntry), entries.size(), file) ==
+            entries.size() &&
+        std::fwrite(stages.data(), sizeof(ShaderArchiveStage), stages.size(), file) ==
+            stages.size() &&
+        std::fwrite(sources.data(), sizeof(ShaderArchiveSource), sources.size(), file) ==
+            sources.size() &&
+        std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    std::fclose(file);
+    CONTEXT_CONDITION_ERROR_RETURN("SHADER", written, -1, "Failed to write shader archive '{}'",
+                                   path);
+    return (int64_t)sources.size();
+}
+
+const ShaderArchiveEntry* ShaderArchive::_Entries() const
+{
+    return (const ShaderArchiveEntry*)(Data.data() + sizeof(ShaderArchiveHeader));
+}
+
+const ShaderArchiveStage* ShaderArchive::_Stages() const
+{
+    return (const ShaderArchiveStage*)(_Entries() + Header.EntryCount);
+}
+
+const ShaderArchiveSource* ShaderArchive::_Sources() const
+{
+    return (const ShaderArchiveSource*)(_Stages() + Header.StageCount);
+}
+
+const char* ShaderArchive::_Text() const
+{
+    return (const char*)(_Sources() + Header.SourceCount);
+}
@@ -0,0 +1,82 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "RHI/ShaderPermutation.h"
+#include <string_view>
+#include <vector>
+
+// Archive layout, every section directly follows the previous one:
+//
+//   ShaderArchiveHeader
+//   ShaderArchiveEntry[EntryCount]     sorted by Key
+//   ShaderArchiveStage[StageCount]     stages of each entry are contiguous
+//   ShaderArchiveSource[SourceCount]   deduplicated stage sources
+//   source text
+struct ShaderArchiveHeader {
+    static constexpr char Magic[8]    = {'K', 'R', 'Y', 'O', 'S', 'S', 'H', 'A'};
+    static constexpr uint32_t Version = 1;
+
+    char FileMagic[8];
+    uint32_t FileVersion;
+    uint32_t EntryCount;
+    uint32_t StageCount;
+    uint32_t SourceCount;
+};
+
+struct ShaderArchiveEntry {
+    uint64_t Key;
+    uint32_t FirstStage;
+    uint32_t StageCount;
+};
+
+struct ShaderArchiveStage {
+    uint32_t Stage;
+    uint32_t Source;
+};
+
+struct ShaderArchiveSource {
+    uint32_t Offset; // From the start of the source text
+    uint32_t Size;
+};
+
+// Preprocessed shader variants packed by KryosShaderCompiler, looked up by ShaderVariantKey
+struct ShaderArchive {
+    std::vector<uint8_t> Data;
+    ShaderArchiveHeader Header {};
+
+    bool Load(std::string_view path);
+    void Destroy();
+
+    // Stage sources of desc point into Data and stay valid until the archive is destroyed
+    bool Find(uint64_t key, ShaderProgramDesc& desc) const;
+    inline bool Find(std::string_view name, const std::vector<std::string_view>& keywords,
+                     ShaderProgramDesc& desc) const
+    {
+        desc.Name = name;
+        return Find(ShaderVariantKey(name, keywords), desc);
+    }
+
+    // Identical stage sources are stored once. Returns the number of unique sources written, or
+    // -1 on failure
+    static int64_t Write(std::string_view path, std::vector<ShaderVariant>& variants);
+
+private:
+    const ShaderArchiveEntry* _Entries() const;
+    const ShaderArchiveStage* _Stages() const;
+    const ShaderArchiveSource* _Sources() const;
+    const char* _Text() const;
+};
@@ -0,0 +1,400 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "RHI/ShaderInclude.h"
+#include "Core/Console.h"
+#include "Core/Hash.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+
+static std::string NormalizePath(std::string_view path)
+{
+    return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+// Returns the directive name of a preprocessor line and its arguments, or false for other lines
+static bool Directive(std::string_view line, std::string_view& name, std::string_view& args)
+{
+    size_t pos = line.find_first_not_of(" \t");
+    if (pos == std::string_view::npos || line[pos] != '#') {
+        return false;
+    }
+    pos        = std::min(line.find_first_not_of(" \t", pos + 1), line.size());
+    size_t end = pos;
+    while (end < line.size() && (std::isalnum((unsigned char)line[end]) || line[end] == '_')) {
+        end++;
+    }
+    name = line.substr(pos, end - pos);
+    args = line.substr(end);
+    args.remove_prefix(std::min(args.find_first_not_of(" \t"), args.size()));
+    args = args.substr(0, args.find_last_not_of(" \t\r") + 1);
+    return true;
+}
+
+static bool NextLine(std::string_view text, size_t& pos, std::string_view& line)
+{
+    if (pos >= text.size()) {
+        return false;
+    }
+    size_t end = std::min(text.find('\n', pos), text.size());
+    line       = text.substr(pos, end - pos);
+    pos        = end + 1;
+    return true;
+}
+
+// Key under which a file is only expanded once: its path for `#pragma once`, the macro for a
+// leading #ifndef/#define pair, empty when the file has no guard
+static std::string IncludeGuard(std::string_view text, const std::string& path)
+{
+    size_t pos = 0;
+    std::string_view line;
+    std::string_view name;
+    std::string_view args;
+    std::string_view macro;
+    uint32_t directive_count = 0;
+    while (NextLine(text, pos, line)) {
+        if (!Directive(line, name, args)) {
+            continue;
+        }
+        if (name == "pragma" && args == "once") {
+            return path;
+        }
+
+        directive_count++;
+        if (directive_count == 1 && name == "ifndef") {
+            macro = args;
+        }
+        else if (directive_count == 2 && !macro.empty() && name == "define" &&
+                 args.substr(0, args.find_first_of(" \t")) == macro) {
+            return "#define " + std::string(macro);
+        }
+    }
+    return {};
+}
+
+bool ShaderPreprocessor::Expand(std::string_view path, std::string& out,
+                                std::vector<ShaderDependency>& dependencies,
+                                std::vector<std::string>& absent, std::string& error)
+{
+    out.clear();
+    dependencies.clear();
+    _Stack.clear();
+    _Guards.clear();
+    _Absent.clear();
+    bool expanded = _Expand(NormalizePath(path), out, dependencies, error);
+    absent.swap(_Absent);
+    return expanded;
+}
+
+bool ShaderPreprocessor::ReadFile(std::string_view path, std::string& text)
+{
+    std::FILE* file = std::fopen(std::string(path).c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    char buffer[4096];
+    size_t read = 0;
+    text.clear();
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        text.append(buffer, read);
+    }
+    std::fclose(file);
+    return true;
+}
+
+bool ShaderPreprocessor::_Expand(const std::string& path, std::string& out,
+                                 std::vector<ShaderDependency>& dependencies, std::string& error)
+{
+    if (std::find(_Stack.begin(), _Stack.end(), path) != _Stack.end()) {
+        error = fmt::format("Include cycle: {} -> {}", fmt::join(_Stack, " -> "), path);
+        return false;
+    }
+    if (_Stack.size() >= MaxDepth) {
+        error = fmt::format("{}: Includes nested deeper than {}", path, MaxDepth);
+        return false;
+    }
+
+    std::string text;
+    if (!ReadFile(path, text)) {
+        error = fmt::format("{}: Failed to read", path);
+        return false;
+    }
+
+    auto it = std::find_if(dependencies.begin(), dependencies.end(),
+                           [&](const ShaderDependency& dep) { return dep.Path == path; });
+    uint32_t source = (uint32_t)(it - dependencies.begin());
+    if (it == dependencies.end()) {
+        dependencies.push_back(ShaderDependency {path, HashString(text)});
+    }
+
+    std::string guard = IncludeGuard(text, path);
+    if (!guard.empty() && !_Guards.insert(guard).second) {
+        return true;
+    }
+
+    // The root keeps its first line untouched, #version has to come before anything else
+    if (!_Stack.empty()) {
+        fmt::format_to(std::back_inserter(out), "#line 1 {}\n", source);
+    }
+    _Stack.push_back(path);
+
+    size_t pos = 0;
+    std::string_view line;
+    uint32_t line_number = 0;
+    while (NextLine(text, pos, line)) {
+        line_number++;
+        std::string_view name;
+        std::string_view args;
+        if (!Directive(line, name, args) || (name != "include" && name != "pragma")) {
+            out.append(line);
+            out.push_back('\n');
+            continue;
+        }
+        if (name == "pragma") {
+            if (args != "once") {
+                out.append(line);
+            }
+            out.push_back('\n');
+            continue;
+        }
+
+        char close = args.empty() ? '\0' : args[0] == '<' ? '>' : args[0] == '"' ? '"' : '\0';
+        size_t end = close != '\0' ? args.find(close, 1) : std::string_view::npos;
+        if (end == std::string_view::npos) {
+            error = fmt::format("{}:{}: Malformed #include", path, line_number);
+            return false;
+        }
+
+        std::string_view include = args.substr(1, end - 1);
+        std::string resolved     = _Resolve(path, include);
+        if (resolved.empty()) {
+            error = fmt::format("{}:{}: Cannot find include '{}'", path, line_number, include);
+            return false;
+        }
+        if (!_Expand(resolved, out, dependencies, error)) {
+            return false;
+        }
+        fmt::format_to(std::back_inserter(out), "#line {} {}\n", line_number + 1, source);
+    }
+
+    _Stack.pop_back();
+    return true;
+}
+
+std::string ShaderPreprocessor::_Resolve(const std::string& from, std::string_view include)
+{
+    auto found = [&](const std::filesystem::path& candidate) {
+        std::error_code error;
+        if (std::filesystem::is_regular_file(candidate, error)) {
+            return true;
+        }
+        std::string path = NormalizePath(candidate.string());
+        if (std::find(_Absent.begin(), _Absent.end(), path) == _Absent.end()) {
+            _Absent.push_back(std::move(path));
+        }
+        return false;
+    };
+
+    std::filesystem::path relative = std::filesystem::path(from).parent_path() / include;
+    if (found(relative)) {
+        return NormalizePath(relative.string());
+    }
+    for (const std::string& directory : IncludeDirectories) {
+        std::filesystem::path candidate = std::filesystem::path(directory) / include;
+        if (found(candidate)) {
+            return NormalizePath(candidate.string());
+        }
+    }
+    return {};
+}
+
+static bool ReadLine(std::FILE* file, std::string& line)
+{
+    line.clear();
+    int c = 0;
+    while ((c = std::fgetc(file)) != EOF && c != '\n') {
+        line.push_back((char)c);
+    }
+    return c != EOF || !line.empty();
+}
+
+// Text format, one record per line:
+//
+//   KRYOSDEP <format version>
+//   tool <tool version>
+//   include <directory>       once per include directory, in search order
+//   shader <dependency count> <absent count> <variant count> <path>
+//   <content hash> <path>     once per dependency, the shader itself first
+//   absent <path>             once per include candidate that was missing
+//   <variant key>             once per variant
+bool ShaderDependencyGraph::Load(std::string_view path)
+{
+    ToolVersion.clear();
+    IncludeDirectories.clear();
+    Nodes.clear();
+    std::FILE* file = std::fopen(std::string(path).c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    std::string line;
+    bool valid = ReadLine(file, line) && line == fmt::format("KRYOSDEP {}", FormatVersion) &&
+                 ReadLine(file, line) && line.compare(0, 5, "tool ") == 0;
+    if (valid) {
+        ToolVersion = line.substr(5);
+    }
+    while (valid && ReadLine(file, line)) {
+        if (line.compare(0, 8, "include ") == 0 && Nodes.empty()) {
+            IncludeDirectories.push_back(line.substr(8));
+            continue;
+        }
+
+        unsigned long long dependency_count = 0;
+        unsigned long long absent_count     = 0;
+        unsigned long long variant_count    = 0;
+        int offset                          = 0;
+        valid = std::sscanf(line.c_str(), "shader %llu %llu %llu %n", &dependency_count,
+                            &absent_count, &variant_count, &offset) == 3 &&
+                offset > 0;
+        if (!valid) {
+            break;
+        }
+
+        ShaderDependencyNode& node = Nodes.emplace_back();
+        node.Shader                = line.substr(offset);
+        for (uint64_t i = 0; valid && i < dependency_count; i++) {
+            unsigned long long hash = 0;
+            valid = ReadLine(file, line) &&
+                    std::sscanf(line.c_str(), "%llx %n", &hash, &offset) == 1 && offset > 0;
+            if (valid) {
+                node.Dependencies.push_back(ShaderDependency {line.substr(offset), hash});
+            }
+        }
+        for (uint64_t i = 0; valid && i < absent_count; i++) {
+            valid = ReadLine(file, line) && line.compare(0, 7, "absent ") == 0;
+            if (valid) {
+                node.Absent.push_back(line.substr(7));
+            }
+        }
+        for (uint64_t i = 0; valid && i < variant_count; i++) {
+            unsigned long long key = 0;
+            valid = ReadLine(file, line) && std::sscanf(line.c_str(), "%llx", &key) == 1;
+            node.Variants.push_back(key);
+        }
+    }
+    std::fclose(file);
+
+    if (!valid) {
+        ToolVersion.clear();
+        IncludeDirectories.clear();
+        Nodes.clear();
+        CONTEXT_WARN_RETURN("SHADER", false, "Ignoring malformed shader dependency file '{}'",
+                            path);
+    }
+    return true;
+}
+
+bool ShaderDependencyGraph::Save(std::string_view path) const
+{
+    std::FILE* file = std::fopen(std::string(path).c_str(), "wb");
+    CONTEXT_CONDITION_ERROR_RETURN("SHADER", file != nullptr, false,
+                                   "Failed to open '{}' to write shader dependencies", path);
+
+    fmt::print(file, "KRYOSDEP {}\ntool {}\n", FormatVersion, ToolVersion);
+    for (const std::string& directory : IncludeDirectories) {
+        fmt::print(file, "include {}\n", directory);
+    }
+    for (const ShaderDependencyNode& node : Nodes) {
+        fmt::print(file, "shader {} {} {} {}\n", node.Dependencies.size(), node.Absent.size(),
+                   node.Variants.size(), node.Shader);
+        for (const ShaderDependency& dependency : node.Dependencies) {
+            fmt::print(file, "{:016x} {}\n", dependency.Hash, dependency.Path);
+        }
+        for (const std::string& absent : node.Absent) {
+            fmt::print(file, "absent {}\n", absent);
+        }
+        for (uint64_t key : node.Variants) {
+            fmt::print(file, "{:016x}\n", key);
+        }
+    }
+    bool written = std::ferror(file) == 0;
+    std::fclose(file);
+    return written;
+}
+
+const ShaderDependencyNode* ShaderDependencyGraph::Find(std::string_view shader) const
+{
+    std::string path = NormalizePath(shader);
+    for (const ShaderDependencyNode& node : Nodes) {
+        if (node.Shader == path) {
+            return &node;
+        }
+    }
+    return nullptr;
+}
+
+const std::string* ShaderDependencyGraph::Changed(const ShaderDependencyNode& node)
+{
+    std::string text;
+    for (const ShaderDependency& dependency : node.Dependencies) {
+        if (!ShaderPreprocessor::ReadFile(dependency.Path, text) ||
+            HashString(text) != dependency.Hash) {
+            return &dependency.Path;
+        }
+    }
+    // A new file at a path searched earlier would now be included instead
+    for (const std::string& absent : node.Absent) {
+        std::error_code error;
+        if (std::filesystem::exists(absent, error)) {
+            return &absent;
+        }
+    }
+    return nullptr;
+}
+
+bool ShaderDependencyGraph::WriteDepfile(std::string_view path, std::string_view output) const
+{
+    std::FILE* file = std::fopen(std::string(path).c_str(), "wb");
+    CONTEXT_CONDITION_ERROR_RETURN("SHADER", file != nullptr, false,
+                                   "Failed to open '{}' to write depfile", path);
+
+    auto write_escaped = [&](std::string_view str) {
+        for (char c : str) {
+            if (c == ' ' || c == '#') {
+                std::fputc('\\', file);
+            }
+            std::fputc(c, file);
+        }
+    };
+
+    std::unordered_set<std::string_view> written;
+    write_escaped(output);
+    std::fputc(':', file);
+    for (const ShaderDependencyNode& node : Nodes) {
+        for (const ShaderDependency& dependency : node.Dependencies) {
+            if (written.insert(dependency.Path).second) {
+                std::fputs(" \\\n  ", file);
+                write_escaped(dependency.Path);
+            }
+        }
+    }
+    std::fputc('\n', file);
+    std::fclose(file);
+    return true;
+}
@@ -0,0 +1,88 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+struct ShaderDependency {
+    std::string Path;
+    uint64_t Hash; // Of the file content
+};
+
+// Expands `#include "path"` and `#include <path>` directives, searching next to the including file
+// first and then IncludeDirectories. Files with `#pragma once` or a classic #ifndef/#define guard
+// are expanded once per shader. `#line <line> <source>` directives are inserted around every
+// include, source being the file's index in the dependency list, so diagnostics map back to files
+//
+// Includes are expanded regardless of the conditionals around them, keyword conditionals are
+// resolved afterwards on the expanded text
+struct ShaderPreprocessor {
+    static constexpr uint32_t MaxDepth = 32;
+
+    std::vector<std::string> IncludeDirectories;
+
+    // dependencies lists path itself first, then every included file once. absent lists the
+    // search candidates that were tried and missing, as creating one would change the result
+    bool Expand(std::string_view path, std::string& out,
+                std::vector<ShaderDependency>& dependencies, std::vector<std::string>& absent,
+                std::string& error);
+
+    static bool ReadFile(std::string_view path, std::string& text);
+
+private:
+    std::vector<std::string> _Stack;
+    std::unordered_set<std::string> _Guards;
+    std::vector<std::string> _Absent;
+
+    bool _Expand(const std::string& path, std::string& out,
+                 std::vector<ShaderDependency>& dependencies, std::string& error);
+    std::string _Resolve(const std::string& from, std::string_view include);
+};
+
+struct ShaderDependencyNode {
+    std::string Shader; // Path of the root file, also Dependencies[0]
+    std::vector<ShaderDependency> Dependencies;
+    std::vector<std::string> Absent; // Include candidates that must stay missing
+    std::vector<uint64_t> Variants; // ShaderVariantKey of every variant built from it
+};
+
+// Include graph of every shader in a build output, persisted alongside it so that a rebuild only
+// preprocesses shaders whose own file or one of its includes changed content. Nodes are only
+// valid for the ToolVersion and IncludeDirectories they were built with
+struct ShaderDependencyGraph {
+    static constexpr uint32_t FormatVersion = 3;
+
+    std::string ToolVersion; // Identifies the compiler build, empty when unknown
+    std::vector<std::string> IncludeDirectories;
+    std::vector<ShaderDependencyNode> Nodes;
+
+    bool Load(std::string_view path);
+    bool Save(std::string_view path) const;
+
+    const ShaderDependencyNode* Find(std::string_view shader) const;
+
+    // Re-hashes every dependency and checks that no absent include appeared, returns the path of
+    // the first one that changed or nullptr when up to date
+    static const std::string* Changed(const ShaderDependencyNode& node);
+
+    // Make style dependency file listing every file output depends on, for build systems to
+    // rerun the shader build when an include changes
+    bool WriteDepfile(std::string_view path, std::string_view output) const;
+};
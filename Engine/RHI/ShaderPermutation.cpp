@@ -0,0 +1,612 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "RHI/ShaderPermutation.h"
+#include "Core/Hash.h"
+#include <algorithm>
+#include <cctype>
+#include <fmt/format.h>
+
+static std::string_view Trim(std::string_view str)
+{
+    size_t begin = 0;
+    size_t end   = str.size();
+    while (begin < end && std::isspace((unsigned char)str[begin])) {
+        begin++;
+    }
+    while (end > begin && std::isspace((unsigned char)str[end - 1])) {
+        end--;
+    }
+    return str.substr(begin, end - begin);
+}
+
+static bool NextLine(std::string_view text, size_t& pos, std::string_view& line)
+{
+    if (pos >= text.size()) {
+        return false;
+    }
+    size_t end = text.find('\n', pos);
+    end        = end == std::string_view::npos ? text.size() : end;
+    line       = text.substr(pos, end - pos);
+    pos        = end + 1;
+    return true;
+}
+
+static bool IdentifierChar(char c)
+{
+    return std::isalnum((unsigned char)c) || c == '_';
+}
+
+static bool ContainsIdentifier(std::string_view text, std::string_view identifier)
+{
+    size_t pos = text.find(identifier);
+    while (pos != std::string_view::npos) {
+        size_t end = pos + identifier.size();
+        if ((pos == 0 || !IdentifierChar(text[pos - 1])) &&
+            (end == text.size() || !IdentifierChar(text[end]))) {
+            return true;
+        }
+        pos = text.find(identifier, pos + 1);
+    }
+    return false;
+}
+
+// Splits "#  name rest" into the directive name and its trimmed arguments
+static bool Directive(std::string_view line, std::string_view& name, std::string_view& args)
+{
+    line = Trim(line);
+    if (line.empty() || line[0] != '#') {
+        return false;
+    }
+    line       = Trim(line.substr(1));
+    size_t end = 0;
+    while (end < line.size() && IdentifierChar(line[end])) {
+        end++;
+    }
+    name = line.substr(0, end);
+    args = Trim(line.substr(end));
+    return true;
+}
+
+static bool ParseStage(std::string_view name, ShaderStage& stage)
+{
+    constexpr std::pair<std::string_view, ShaderStage> stages[] = {
+        {"vertex", ShaderStage_Vertex},
+        {"fragment", ShaderStage_Fragment},
+        {"geometry", ShaderStage_Geometry},
+        {"compute", ShaderStage_Compute},
+    };
+    for (const auto& [stage_name, value] : stages) {
+        if (name == stage_name) {
+            stage = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+// `#line <line> [source]` sets the number of the next line and optionally the source file
+static void LineDirective(std::string_view args, uint32_t& line_number, uint32_t& source_id)
+{
+    std::string str(args);
+    char* end   = nullptr;
+    line_number = (uint32_t)std::strtoul(str.c_str(), &end, 10) - 1;
+    if (end != nullptr && *end != '\0') {
+        source_id = (uint32_t)std::strtoul(end, nullptr, 10);
+    }
+}
+
+// Evaluates #if expressions made of keywords, defined(), !, &&, ||, parentheses and integer
+// literals. Anything else clears Resolved so the conditional is passed through to the driver
+struct ShaderCondition {
+    const ShaderSourceFile& File;
+    const std::vector<std::string_view>& Enabled;
+    std::string_view Text;
+    size_t Pos    = 0;
+    bool Resolved = true;
+
+    bool Evaluate()
+    {
+        size_t comment = Text.find("//");
+        Text           = Text.substr(0, comment);
+        bool value     = Or();
+        SkipSpace();
+        Resolved = Resolved && Pos == Text.size();
+        return value;
+    }
+
+    void SkipSpace()
+    {
+        while (Pos < Text.size() && std::isspace((unsigned char)Text[Pos])) {
+            Pos++;
+        }
+    }
+
+    bool Match(std::string_view token)
+    {
+        SkipSpace();
+        if (Text.substr(Pos, token.size()) == token) {
+            Pos += token.size();
+            return true;
+        }
+        return false;
+    }
+
+    std::string_view Identifier()
+    {
+        SkipSpace();
+        size_t begin = Pos;
+        while (Pos < Text.size() && IdentifierChar(Text[Pos])) {
+            Pos++;
+        }
+        return Text.substr(begin, Pos - begin);
+    }
+
+    bool KeywordValue(std::string_view identifier)
+    {
+        if (!File.Keyword(identifier)) {
+            Resolved = false;
+            return false;
+        }
+        return std::find(Enabled.begin(), Enabled.end(), identifier) != Enabled.end();
+    }
+
+    bool Or()
+    {
+        bool value = And();
+        while (Resolved && Match("||")) {
+            value = And() || value;
+        }
+        return value;
+    }
+
+    bool And()
+    {
+        bool value = Unary();
+        while (Resolved && Match("&&")) {
+            value = Unary() && value;
+        }
+        return value;
+    }
+
+    bool Unary()
+    {
+        if (Match("!")) {
+            return !Unary();
+        }
+        return Primary();
+    }
+
+    bool Primary()
+    {
+        if (Match("(")) {
+            bool value = Or();
+            Resolved   = Resolved && Match(")");
+            return value;
+        }
+
+        std::string_view identifier = Identifier();
+        if (identifier.empty()) {
+            Resolved = false;
+            return false;
+        }
+        if (std::isdigit((unsigned char)identifier[0])) {
+            return identifier.find_first_not_of('0') != std::string_view::npos;
+        }
+        if (identifier == "defined") {
+            bool paren = Match("(");
+            bool value = KeywordValue(Identifier());
+            Resolved   = Resolved && (!paren || Match(")"));
+            return value;
+        }
+        return KeywordValue(identifier);
+    }
+};
+
+// Writes a driver resolved #if or #elif with every keyword replaced by 1 or 0, as disabled
+// keywords are never defined and enabled ones only when referenced outside of directives
+static void RewriteCondition(const ShaderSourceFile& file,
+                             const std::vector<std::string_view>& enabled, std::string_view name,
+                             std::string_view args, std::string& out)
+{
+    auto skip_space = [&](size_t pos) {
+        while (pos < args.size() && std::isspace((unsigned char)args[pos])) {
+            pos++;
+        }
+        return pos;
+    };
+    auto identifier_end = [&](size_t pos) {
+        while (pos < args.size() && IdentifierChar(args[pos])) {
+            pos++;
+        }
+        return pos;
+    };
+    auto value = [&](std::string_view keyword) {
+        return std::find(enabled.begin(), enabled.end(), keyword) != enabled.end() ? '1' : '0';
+    };
+
+    fmt::format_to(std::back_inserter(out), "#{} ", name);
+    size_t pos = 0;
+    while (pos < args.size()) {
+        size_t begin = pos;
+        pos          = identifier_end(pos);
+        if (pos == begin) {
+            out.push_back(args[pos++]);
+            continue;
+        }
+
+        std::string_view token = args.substr(begin, pos - begin);
+        if (token == "defined") {
+            size_t operand = skip_space(pos);
+            bool paren     = operand < args.size() && args[operand] == '(';
+            operand        = paren ? skip_space(operand + 1) : operand;
+            size_t end     = identifier_end(operand);
+            size_t close   = paren ? skip_space(end) : end;
+            if (end > operand && (!paren || (close < args.size() && args[close] == ')')) &&
+                file.Keyword(args.substr(operand, end - operand))) {
+                out.push_back(value(args.substr(operand, end - operand)));
+                pos = paren ? close + 1 : end;
+                continue;
+            }
+        }
+        else if (file.Keyword(token)) {
+            out.push_back(value(token));
+            continue;
+        }
+        out.append(token);
+    }
+}
+
+struct ShaderConditionalBlock {
+    bool Resolved; // False when the directives are passed through to the driver
+    bool ParentActive;
+    bool Active;
+    bool Taken; // A branch of a resolved block was already selected
+    uint32_t Line;
+    uint32_t Source;
+};
+
+// False when a driver resolved conditional encloses the line, so whether it is compiled is unknown
+static bool Certain(const std::vector<ShaderConditionalBlock>& blocks)
+{
+    return std::all_of(blocks.begin(), blocks.end(),
+                       [](const ShaderConditionalBlock& block) { return block.Resolved; });
+}
+
+// Blanks out inactive lines and resolved directives instead of removing them, so that line
+// numbers in driver diagnostics still match the file
+static bool ResolveConditionals(const ShaderSourceFile& file,
+                                const std::vector<std::string_view>& enabled,
+                                std::string_view source, std::string& out, std::string& error)
+{
+    std::vector<ShaderConditionalBlock> blocks;
+    size_t pos = 0;
+    std::string_view line;
+    uint32_t line_number = 0;
+    uint32_t source_id   = 0;
+
+    out.clear();
+    out.reserve(source.size());
+    while (NextLine(source, pos, line)) {
+        line_number++;
+        bool active  = blocks.empty() || blocks.back().Active;
+        bool emit    = active;
+        bool rewrite = false;
+
+        std::string_view name;
+        std::string_view args;
+        if (Directive(line, name, args)) {
+            if (name == "line") {
+                LineDirective(args, line_number, source_id);
+            }
+            else if (name == "if" || name == "ifdef" || name == "ifndef") {
+                bool value    = false;
+                bool resolved = false;
+                if (name == "if") {
+                    ShaderCondition condition {file, enabled, args};
+                    value    = condition.Evaluate();
+                    resolved = condition.Resolved;
+                }
+                else if (file.Keyword(args)) {
+                    bool defined =
+                        std::find(enabled.begin(), enabled.end(), args) != enabled.end();
+                    value    = name == "ifdef" ? defined : !defined;
+                    resolved = true;
+                }
+                blocks.push_back(ShaderConditionalBlock {
+                    .Resolved     = resolved,
+                    .ParentActive = active,
+                    .Active       = active && (!resolved || value),
+                    .Taken        = resolved && value,
+                    .Line         = line_number,
+                    .Source       = source_id,
+                });
+                emit    = active && !resolved;
+                rewrite = name == "if";
+            }
+            else if (name == "elif" || name == "else" || name == "endif") {
+                if (blocks.empty()) {
+                    error = fmt::format("{}: #{} without #if",
+                                        file.Location(source_id, line_number), name);
+                    return false;
+                }
+
+                ShaderConditionalBlock& block = blocks.back();
+                emit                          = block.ParentActive && !block.Resolved;
+                rewrite                       = name == "elif";
+                if (name == "endif") {
+                    blocks.pop_back();
+                }
+                else if (block.Resolved && name == "else") {
+                    block.Active = block.ParentActive && !block.Taken;
+                    block.Taken  = true;
+                }
+                else if (block.Resolved) {
+                    ShaderCondition condition {file, enabled, args};
+                    bool value = condition.Evaluate();
+                    if (block.Taken) {
+                        block.Active = false;
+                    }
+                    else if (condition.Resolved) {
+                        block.Active = block.ParentActive && value;
+                        block.Taken  = value;
+                    }
+                    else {
+                        // Earlier branches were all false, so the rest becomes a driver #if
+                        block.Resolved = false;
+                        block.Active   = block.ParentActive;
+                        if (block.ParentActive) {
+                            RewriteCondition(file, enabled, "if", args, out);
+                            out.push_back('\n');
+                            continue;
+                        }
+                    }
+                }
+            }
+            else if (name == "error" && active && Certain(blocks)) {
+                error = fmt::format("{}: #error {}", file.Location(source_id, line_number), args);
+                return false;
+            }
+        }
+
+        if (emit && rewrite) {
+            RewriteCondition(file, enabled, name, args, out);
+        }
+        else if (emit) {
+            out.append(line);
+        }
+        out.push_back('\n');
+    }
+
+    if (!blocks.empty()) {
+        const ShaderConditionalBlock& block = blocks.back();
+
+        error = fmt::format("{}: Unterminated conditional",
+                            file.Location(block.Source, block.Line));
+        return false;
+    }
+    return true;
+}
+
+// Checks that what the driver will see has an entry point and balanced braces, comments are
+// skipped but strings are not as GLSL has none
+static bool ValidateStage(const ShaderSourceFile& file, const ShaderSourceStage& stage,
+                          std::string& error)
+{
+    std::string_view source = stage.Source;
+    int64_t depth           = 0;
+    bool has_main           = false;
+    for (size_t i = 0; i < source.size(); i++) {
+        if (source.substr(i, 2) == "//") {
+            i = std::min(source.find('\n', i), source.size());
+        }
+        else if (source.substr(i, 2) == "/*") {
+            i = std::min(source.find("*/", i + 2), source.size()) + 1;
+        }
+        else if (source[i] == '{') {
+            depth++;
+        }
+        else if (source[i] == '}' && --depth < 0) {
+            break;
+        }
+        else if (source.substr(i, 4) == "main" && (i == 0 || !IdentifierChar(source[i - 1]))) {
+            size_t next = source.find_first_not_of(" \t\r\n", i + 4);
+            has_main    = has_main || (next != std::string_view::npos && source[next] == '(');
+        }
+    }
+
+    std::string location = file.Location(stage.FirstSource, stage.FirstLine);
+    if (depth != 0) {
+        error = fmt::format("{}: Unbalanced braces in stage", location);
+        return false;
+    }
+    if (!has_main) {
+        error = fmt::format("{}: Stage has no main function", location);
+        return false;
+    }
+    return true;
+}
+
+uint64_t ShaderVariantKey(std::string_view name, const std::vector<std::string_view>& keywords)
+{
+    // Summing keeps the key independent of the order keywords are given in
+    uint64_t keyword_sum = 0;
+    for (std::string_view keyword : keywords) {
+        keyword_sum += HashString(keyword);
+    }
+    return HashBytes(&keyword_sum, sizeof(keyword_sum), HashString(name));
+}
+
+bool ShaderSourceFile::Parse(std::string_view name, std::string_view text, std::string& error)
+{
+    Name = name;
+    Common.clear();
+    KeywordGroups.clear();
+    Stages.clear();
+
+    size_t pos = 0;
+    std::string_view line;
+    uint32_t line_number = 0;
+    uint32_t source_id   = 0;
+    while (NextLine(text, pos, line)) {
+        line_number++;
+        std::string& current = Stages.empty() ? Common : Stages.back().Source;
+
+        std::string_view directive;
+        std::string_view args;
+        bool is_directive = Directive(line, directive, args);
+        if (is_directive && directive == "line") {
+            LineDirective(args, line_number, source_id);
+        }
+        if (!is_directive || directive != "pragma") {
+            current.append(line);
+            current.push_back('\n');
+            continue;
+        }
+
+        std::string_view pragma = args.substr(0, args.find_first_of(" \t"));
+        args                    = Trim(args.substr(pragma.size()));
+        if (pragma == "stage") {
+            ShaderStage stage;
+            if (!ParseStage(args, stage)) {
+                error = fmt::format("{}: Unknown stage '{}'", Location(source_id, line_number),
+                                    args);
+                return false;
+            }
+            Stages.push_back(ShaderSourceStage {stage, {}, line_number + 1, source_id});
+        }
+        else if (pragma == "keywords") {
+            ShaderKeywordGroup& group = KeywordGroups.emplace_back();
+            while (!args.empty()) {
+                size_t end               = std::min(args.find_first_of(" \t"), args.size());
+                std::string_view keyword = args.substr(0, end);
+                args                     = Trim(args.substr(end));
+
+                if (keyword != "_" && Keyword(keyword)) {
+                    error = fmt::format("{}: Keyword '{}' is already declared",
+                                        Location(source_id, line_number), keyword);
+                    return false;
+                }
+                group.Keywords.emplace_back(keyword);
+            }
+            if (group.Keywords.empty()) {
+                error = fmt::format("{}: Empty keyword group", Location(source_id, line_number));
+                return false;
+            }
+            // Keeps line numbers of the common section intact
+            current.push_back('\n');
+        }
+        else {
+            current.append(line);
+            current.push_back('\n');
+        }
+    }
+
+    if (Stages.empty()) {
+        error = fmt::format("{}: No '#pragma stage' found", Name);
+        return false;
+    }
+
+    uint64_t permutations = 1;
+    for (const ShaderKeywordGroup& group : KeywordGroups) {
+        permutations *= group.Keywords.size();
+        if (permutations > MaxPermutations) {
+            error = fmt::format("{}: More than {} permutations", Name, MaxPermutations);
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t ShaderSourceFile::PermutationCount() const
+{
+    uint32_t count = 1;
+    for (const ShaderKeywordGroup& group : KeywordGroups) {
+        count *= (uint32_t)group.Keywords.size();
+    }
+    return count;
+}
+
+void ShaderSourceFile::PermutationKeywords(uint32_t permutation,
+                                          std::vector<std::string_view>& keywords) const
+{
+    keywords.clear();
+    for (const ShaderKeywordGroup& group : KeywordGroups) {
+        uint32_t size              = (uint32_t)group.Keywords.size();
+        const std::string& keyword = group.Keywords[permutation % size];
+        permutation /= size;
+        if (keyword != "_") {
+            keywords.emplace_back(keyword);
+        }
+    }
+}
+
+bool ShaderSourceFile::BuildVariant(uint32_t permutation, ShaderVariant& variant,
+                                    std::string& error) const
+{
+    std::vector<std::string_view> enabled;
+    PermutationKeywords(permutation, enabled);
+    variant.Key = ShaderVariantKey(Name, enabled);
+    variant.Stages.clear();
+
+    std::string source;
+    std::string resolved;
+    std::vector<ShaderDefine> defines;
+    for (const ShaderSourceStage& stage : Stages) {
+        source = Common;
+        fmt::format_to(std::back_inserter(source), "#line {} {}\n", stage.FirstLine,
+                       stage.FirstSource);
+        source.append(stage.Source);
+        if (!ResolveConditionals(*this, enabled, source, resolved, error)) {
+            return false;
+        }
+
+        defines.clear();
+        for (std::string_view keyword : enabled) {
+            if (ContainsIdentifier(resolved, keyword)) {
+                defines.push_back(ShaderDefine {keyword, "1"});
+            }
+        }
+
+        variant.Stages.push_back(ShaderSourceStage {
+            .Stage       = stage.Stage,
+            .Source      = defines.empty() ? resolved : Shader::ComposeSource(resolved, defines),
+            .FirstLine   = stage.FirstLine,
+            .FirstSource = stage.FirstSource,
+        });
+        if (!ValidateStage(*this, variant.Stages.back(), error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ShaderSourceFile::Keyword(std::string_view identifier) const
+{
+    for (const ShaderKeywordGroup& group : KeywordGroups) {
+        for (const std::string& keyword : group.Keywords) {
+            if (keyword == identifier && keyword != "_") {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+std::string ShaderSourceFile::Location(uint32_t source, uint32_t line) const
+{
+    std::string_view name = source < SourceNames.size() ? SourceNames[source] : Name;
+    return fmt::format("{}:{}", name, line);
+}
@@ -0,0 +1,72 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "RHI/Shader.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Declared in shader source as `#pragma keywords _ SHADOWS_LOW SHADOWS_HIGH`, every permutation
+// enables exactly one keyword per group where `_` enables none of them. Enabled keywords are
+// defined as 1
+struct ShaderKeywordGroup {
+    std::vector<std::string> Keywords;
+};
+
+struct ShaderSourceStage {
+    ShaderStage Stage;
+    std::string Source;
+    uint32_t FirstLine; // Where the stage body starts, for diagnostics
+    uint32_t FirstSource;
+};
+
+struct ShaderVariant {
+    uint64_t Key;
+    std::vector<ShaderSourceStage> Stages; // Preprocessed and ready to compile
+};
+
+// Key of a shader variant by name and enabled keywords, independent of keyword order
+uint64_t ShaderVariantKey(std::string_view name, const std::vector<std::string_view>& keywords);
+
+// A shader file, usually expanded by ShaderPreprocessor first, split at
+// `#pragma stage <vertex|fragment|geometry|compute>` lines. Everything before the first stage,
+// such as #version and shared declarations, is common to all stages
+struct ShaderSourceFile {
+    static constexpr uint32_t MaxPermutations = 1 << 16;
+
+    std::string Name;
+    std::vector<std::string> SourceNames; // Files numbered by `#line <line> <source>` directives
+    std::string Common;
+    std::vector<ShaderKeywordGroup> KeywordGroups;
+    std::vector<ShaderSourceStage> Stages;
+
+    // On failure error holds a "name:line: message" diagnostic
+    bool Parse(std::string_view name, std::string_view text, std::string& error);
+
+    uint32_t PermutationCount() const;
+    // Permutations are numbered in mixed radix over KeywordGroups, first group varies fastest
+    void PermutationKeywords(uint32_t permutation, std::vector<std::string_view>& keywords) const;
+
+    // Resolves conditionals that only depend on keywords and validates the result, conditionals
+    // on anything else are left for the driver with their keywords replaced by 1 or 0. Enabled
+    // keywords still referenced afterwards are defined, so stages that do not depend on a keyword
+    // come out identical across its variants
+    bool BuildVariant(uint32_t permutation, ShaderVariant& variant, std::string& error) const;
+
+    bool Keyword(std::string_view identifier) const;
+    std::string Location(uint32_t source, uint32_t line) const;
+};
@@ -0,0 +1,137 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "RHI/StaticBatch.h"
+#include "Core/Console.h"
+#include "Core/Profiler.h"
+#include <cstring>
+
+void StaticGeometryPool::Initialize(uint32_t vertex_stride)
+{
+    VertexStride = vertex_stride;
+    Vertices.clear();
+    Indices.clear();
+    Meshes.clear();
+}
+
+void StaticGeometryPool::Destroy()
+{
+    if (VertexBuffer != 0 || IndexBuffer != 0) {
+        _DestroyBuffers();
+    }
+    VertexBuffer = 0;
+    IndexBuffer  = 0;
+    Vertices.clear();
+    Indices.clear();
+    Meshes.clear();
+}
+
+uint32_t StaticGeometryPool::AddMesh(const void* vertices, uint32_t vertex_count,
+                                     const uint32_t* indices, uint32_t index_count)
+{
+    StaticMeshRange range {
+        .FirstIndex  = (uint32_t)Indices.size(),
+        .IndexCount  = index_count,
+        .BaseVertex  = (int32_t)(Vertices.size() / VertexStride),
+        .VertexCount = vertex_count,
+    };
+
+    size_t vertex_offset = Vertices.size();
+    Vertices.resize(vertex_offset + (size_t)vertex_count * VertexStride);
+    std::memcpy(Vertices.data() + vertex_offset, vertices, (size_t)vertex_count * VertexStride);
+    Indices.insert(Indices.end(), indices, indices + index_count);
+
+    Meshes.push_back(range);
+    return (uint32_t)Meshes.size() - 1;
+}
+
+bool StaticGeometryPool::Upload()
+{
+    CONTEXT_CONDITION_ERROR_RETURN("BATCH", !Vertices.empty() && !Indices.empty(), false,
+                                   "Static geometry pool has no meshes to upload");
+    if (VertexBuffer != 0 || IndexBuffer != 0) {
+        _DestroyBuffers();
+    }
+    return _CreateBuffers();
+}
+
+void StaticBatch::Build(const StaticGeometryPool& pool, const StaticObject* objects,
+                        const uint32_t* visible, uint32_t visible_count)
+{
+    PROFILE_SCOPE("StaticBatch::Build");
+    MeshOffsets.assign(pool.Meshes.size(), 0);
+    for (uint32_t i = 0; i < visible_count; i++) {
+        MeshOffsets[objects[visible[i]].Mesh]++;
+    }
+
+    // Visible counts become each mesh's first instance, unused meshes emit no command
+    Commands.clear();
+    uint32_t first_instance = 0;
+    for (uint32_t mesh = 0; mesh < pool.Meshes.size(); mesh++) {
+        uint32_t count = MeshOffsets[mesh];
+        if (count == 0) {
+            continue;
+        }
+
+        const StaticMeshRange& range = pool.Meshes[mesh];
+        Commands.push_back(RenderDrawIndexedIndirectArgs {
+            .IndexCount    = range.IndexCount,
+            .InstanceCount = count,
+            .FirstIndex    = range.FirstIndex,
+            .BaseVertex    = range.BaseVertex,
+            .FirstInstance = first_instance,
+        });
+        MeshOffsets[mesh] = first_instance;
+
+        first_instance += count;
+    }
+
+    Instances.resize(visible_count);
+    for (uint32_t i = 0; i < visible_count; i++) {
+        const StaticObject& object = objects[visible[i]];
+
+        Instances[MeshOffsets[object.Mesh]++] = object.Data;
+    }
+}
+
+bool StaticBatch::Record(RenderCommandBuffer& commands, RenderUploadRing& uploads,
+                         const StaticGeometryPool& pool, RenderHandle vertex_array) const
+{
+    if (Commands.empty()) {
+        return true;
+    }
+
+    uint64_t instance_size = Instances.size() * sizeof(StaticInstanceData);
+    uint64_t command_size  = Commands.size() * sizeof(RenderDrawIndexedIndirectArgs);
+
+    // One allocation holds both, so a full ring never keeps the instances without their
+    // arguments. Instance data is 64 byte sized, leaving the arguments after it 4 byte aligned
+    static_assert(sizeof(StaticInstanceData) % 4 == 0);
+    RenderUploadAllocation upload = uploads.AllocateStorage(instance_size + command_size);
+    if (upload.Data == nullptr) {
+        return false;
+    }
+    std::memcpy(upload.Data, Instances.data(), instance_size);
+    std::memcpy((uint8_t*)upload.Data + instance_size, Commands.data(), command_size);
+
+    commands.BindVertexArray(vertex_array);
+    commands.BindVertexBuffer(0, pool.VertexBuffer, pool.VertexStride);
+    commands.BindBuffer(RenderBufferTarget_Index, pool.IndexBuffer);
+    commands.BindBuffer(RenderBufferTarget_Storage, upload.Buffer, InstanceSlot, upload.Offset,
+                        instance_size);
+    commands.BindBuffer(RenderBufferTarget_Indirect, upload.Buffer);
+    commands.DrawIndexedIndirect(upload.Offset + instance_size, (uint32_t)Commands.size());
+    return true;
+}
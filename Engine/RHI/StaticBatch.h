@@ -0,0 +1,93 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "RHI/CommandBuffer.h"
+#include "RHI/UploadRing.h"
+#include <cstdint>
+#include <vector>
+
+// Where a mesh landed inside the shared buffers of a StaticGeometryPool
+struct StaticMeshRange {
+    uint32_t FirstIndex;
+    uint32_t IndexCount;
+    int32_t BaseVertex;
+    uint32_t VertexCount;
+};
+
+// Static meshes merged into one vertex and one 32 bit index buffer, so every draw from the pool
+// shares the same bindings. Meshes are appended on the CPU and sent to the GPU by Upload, adding
+// meshes afterwards needs another Upload which recreates both buffers
+struct StaticGeometryPool {
+    uint32_t VertexStride = 0;
+    std::vector<uint8_t> Vertices;
+    std::vector<uint32_t> Indices;
+    std::vector<StaticMeshRange> Meshes;
+    RenderHandle VertexBuffer = 0;
+    RenderHandle IndexBuffer  = 0;
+
+    void Initialize(uint32_t vertex_stride);
+    void Destroy();
+
+    // Returns the mesh id, indices are relative to the mesh's own first vertex
+    uint32_t AddMesh(const void* vertices, uint32_t vertex_count, const uint32_t* indices,
+                     uint32_t index_count);
+
+    // Requires the graphics context to be current. Fails when the context can't run the
+    // gl_BaseInstance lookup StaticInstanceData relies on
+    bool Upload();
+
+private:
+    // Backend specific, creates immutable buffers holding Vertices and Indices
+    bool _CreateBuffers();
+    void _DestroyBuffers();
+};
+
+// Per object data in the instance storage buffer, laid out for std430. Shaders find their entry
+// at gl_BaseInstance + gl_InstanceID (GL 4.6 or ARB_shader_draw_parameters)
+struct StaticInstanceData {
+    float Transform[12]; // Row major 3x4 model matrix
+    uint32_t Material;
+    uint32_t Object;
+    uint32_t Padding[2];
+};
+
+struct StaticObject {
+    uint32_t Mesh;
+    StaticInstanceData Data;
+};
+
+// Turns the visible objects of a StaticGeometryPool into indirect draw arguments and instance
+// data, submitted as one DrawIndexedIndirect. Objects are grouped by mesh with a counting sort, so
+// every mesh is a single instanced draw however many objects use it
+struct StaticBatch {
+    static constexpr uint16_t InstanceSlot = 1; // Storage buffer binding of StaticInstanceData
+
+    std::vector<RenderDrawIndexedIndirectArgs> Commands;
+    std::vector<StaticInstanceData> Instances;
+    std::vector<uint32_t> MeshOffsets; // Scratch, first instance of each mesh
+
+    // visible indexes into objects, Instances keeps the visible order within a mesh
+    void Build(const StaticGeometryPool& pool, const StaticObject* objects,
+               const uint32_t* visible, uint32_t visible_count);
+
+    // Writes the arguments and instance data of the last Build to the upload ring and records the
+    // binds plus the single multi draw. vertex_array must describe pool.VertexStride sized
+    // vertices on binding 0. Returns false when the upload ring is out of space, in which case
+    // nothing was allocated
+    bool Record(RenderCommandBuffer& commands, RenderUploadRing& uploads,
+                const StaticGeometryPool& pool, RenderHandle vertex_array) const;
+};
@@ -0,0 +1,114 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "RHI/UploadRing.h"
+#include "Core/Console.h"
+#include "Core/Profiler.h"
+#include "Core/Time.h"
+#include <algorithm>
+#include <cstring>
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+bool RenderUploadRing::Initialize(uint64_t frame_size, uint32_t frame_count)
+{
+    CONTEXT_CONDITION_ERROR_RETURN("UPLOAD", frame_count > 0 && frame_count <= MaxFrames, false,
+                                   "Upload ring needs 1 to {} frames, got {}", MaxFrames,
+                                   frame_count);
+
+    _QueryLimits();
+    uint64_t alignment = std::max(UniformAlignment, StorageAlignment);
+    FrameCount         = frame_count;
+    FrameSize          = AlignUp(std::max(frame_size, (uint64_t)1), alignment);
+    Frame              = frame_count - 1;
+    Head               = 0;
+    Stats              = RenderUploadStats {};
+    _Overflowed        = false;
+    std::fill(Fences, Fences + MaxFrames, nullptr);
+    return _CreateBuffer();
+}
+
+void RenderUploadRing::Destroy()
+{
+    if (Mapped == nullptr) {
+        return;
+    }
+    for (uint32_t frame = 0; frame < FrameCount; frame++) {
+        _WaitFence(frame);
+    }
+    _DestroyBuffer();
+    Mapped = nullptr;
+    Buffer = 0;
+}
+
+void RenderUploadRing::BeginFrame()
+{
+    PROFILE_FUNCTION();
+    Frame       = (Frame + 1) % FrameCount;
+    Head        = 0;
+    _Overflowed = false;
+
+    uint64_t start = Time::NowNanoseconds();
+    if (_WaitFence(Frame)) {
+        uint64_t stall = Time::NowNanoseconds() - start;
+        Stats.StallCount++;
+        Stats.StallNanoseconds += stall;
+        PROFILE_COUNTER("Upload Stall us", stall / 1000);
+    }
+}
+
+void RenderUploadRing::EndFrame()
+{
+    PROFILE_COUNTER("Upload Bytes", Head);
+    Stats.PeakFrameBytes = std::max(Stats.PeakFrameBytes, Head);
+    _InsertFence(Frame);
+}
+
+RenderUploadAllocation RenderUploadRing::Allocate(uint64_t size, uint64_t alignment)
+{
+    uint64_t offset = AlignUp(Head, alignment);
+    if (Mapped == nullptr || offset + size > FrameSize) {
+        Stats.OverflowCount++;
+        if (!_Overflowed) {
+            CONTEXT_WARN("UPLOAD", "Upload ring frame of {} bytes is full, dropping {} bytes",
+                         FrameSize, size);
+            _Overflowed = true;
+        }
+        return RenderUploadAllocation {};
+    }
+
+    Head = offset + size;
+
+    offset += (uint64_t)Frame * FrameSize;
+    return RenderUploadAllocation {
+        .Data   = Mapped + offset,
+        .Buffer = Buffer,
+        .Offset = offset,
+        .Size   = size,
+    };
+}
+
+RenderUploadAllocation RenderUploadRing::Upload(const void* data, uint64_t size,
+                                                uint64_t alignment)
+{
+    RenderUploadAllocation allocation = Allocate(size, alignment);
+    if (allocation.Data != nullptr) {
+        std::memcpy(allocation.Data, data, size);
+    }
+    return allocation;
+}
@@ -0,0 +1,89 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "RHI/CommandBuffer.h"
+#include <cstdint>
+
+// Write-only memory inside the upload ring, valid until the end of the frame it was allocated in
+struct RenderUploadAllocation {
+    void* Data          = nullptr; // nullptr when the frame ran out of space
+    RenderHandle Buffer = 0;
+    uint64_t Offset     = 0;
+    uint64_t Size       = 0;
+};
+
+// Fence waits since Initialize, a stall is a wait on a region the GPU was still reading
+struct RenderUploadStats {
+    uint64_t StallCount       = 0;
+    uint64_t StallNanoseconds = 0;
+    uint64_t OverflowCount    = 0; // Allocations refused because the frame region was full
+    uint64_t PeakFrameBytes   = 0;
+};
+
+// One mapped buffer split into FrameCount regions that are written in turn, so per-draw constants
+// and dynamic geometry are bump allocated and written in place instead of being copied by the
+// driver. Each region is fenced once its frame is submitted and BeginFrame only waits when the CPU
+// gets FrameCount frames ahead of the GPU
+struct RenderUploadRing {
+    static constexpr uint32_t MaxFrames = 4;
+
+    RenderHandle Buffer       = 0;
+    uint8_t* Mapped           = nullptr;
+    uint64_t FrameSize        = 0;
+    uint32_t FrameCount       = 0;
+    uint32_t Frame            = 0; // Region written this frame
+    uint64_t Head             = 0; // Bytes allocated from the region this frame
+    uint32_t UniformAlignment = 256;
+    uint32_t StorageAlignment = 256;
+    void* Fences[MaxFrames]   = {}; // Backend sync object per region, nullptr once signaled
+    RenderUploadStats Stats;
+
+    // Requires the graphics context to be current, frame_size is rounded up to the alignments
+    bool Initialize(uint64_t frame_size, uint32_t frame_count = 3);
+    void Destroy();
+
+    // Moves to the next region, waiting for the GPU to finish reading it. Call once per frame
+    // before any allocation
+    void BeginFrame();
+    // Fences the region written this frame, call after the frame's draws have been submitted
+    void EndFrame();
+
+    RenderUploadAllocation Allocate(uint64_t size, uint64_t alignment = 16);
+    RenderUploadAllocation Upload(const void* data, uint64_t size, uint64_t alignment = 16);
+
+    inline RenderUploadAllocation AllocateUniform(uint64_t size)
+    {
+        return Allocate(size, UniformAlignment);
+    }
+
+    inline RenderUploadAllocation AllocateStorage(uint64_t size)
+    {
+        return Allocate(size, StorageAlignment);
+    }
+
+private:
+    bool _Overflowed = false;
+
+    // Backend specific. _QueryLimits fills in the binding alignments, _CreateBuffer creates and
+    // maps Buffer for FrameSize * FrameCount bytes
+    void _QueryLimits();
+    bool _CreateBuffer();
+    void _DestroyBuffer();
+    // Returns true when the GPU was still reading the region
+    bool _WaitFence(uint32_t frame);
+    void _InsertFence(uint32_t frame);
+};
@@ -3,6 +3,9 @@
 
 void WindowHandle::InitializeGLFW()
 {
+#ifdef KRYOS_RHI_NULL
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
     RHI_CONDITION_FATAL(glfwInit() == GLFW_TRUE, "Failed to initialize GLFW");
 }
 
@@ -25,6 +28,16 @@ bool WindowHandle::Closing() const
     return glfwWindowShouldClose(WindowPtr);
 }
 
+bool WindowHandle::Focused() const
+{
+    return glfwGetWindowAttrib(WindowPtr, GLFW_FOCUSED) == GLFW_TRUE;
+}
+
+bool WindowHandle::Iconified() const
+{
+    return glfwGetWindowAttrib(WindowPtr, GLFW_ICONIFIED) == GLFW_TRUE;
+}
+
 const std::string_view WindowHandle::Title() const
 {
     return std::string_view(glfwGetWindowTitle(WindowPtr));
@@ -55,8 +68,3 @@ void WindowHandle::Close(bool close)
 {
     glfwSetWindowShouldClose(WindowPtr, close);
 }
-
-void WindowHandle::MakeCurrentContext() const
-{
-    glfwMakeContextCurrent(WindowPtr);
-}
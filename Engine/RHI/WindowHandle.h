@@ -29,6 +29,8 @@ enum WindowHandleFlags {
     WindowHandle_TrippleBufferBit     = 1 << 4,
     WindowHandle_ResizeableBit        = 1 << 5,
     WindowHandle_TransparentBufferBit = 1 << 6,
+    WindowHandle_AdaptiveVsyncBit     = 1 << 7, // Tears instead of stalling on late frames
+    WindowHandle_HiddenBit            = 1 << 8, // Context only, for offscreen tools
 };
 
 struct WindowHandle {
@@ -47,7 +49,10 @@ struct WindowHandle {
     void Destroy();
 
     bool Closing() const;
+    bool Focused() const;
+    bool Iconified() const;
     void SwapBuffers();
+    void SetVsync(bool vsync, bool adaptive = false);
     inline bool Valid() const { return WindowPtr != nullptr; }
 
     const std::string_view Title() const;
@@ -57,4 +62,5 @@ struct WindowHandle {
 
     void Close(bool close = true);
     void MakeCurrentContext() const;
+    static void ClearCurrentContext();
 };
@@ -0,0 +1,19 @@
+#ifdef KRYOS_RHI_NULL
+
+#    include "RHI/CommandBuffer.h"
+
+uint32_t RenderCommandBuffer::Execute() const
+{
+    uint32_t executed     = 0;
+    const uint8_t* packet = Data.data();
+    const uint8_t* end    = packet + Data.size();
+    while (packet < end) {
+        RenderCommandHeader header;
+        std::memcpy(&header, packet, sizeof(header));
+        packet += header.Size;
+        executed++;
+    }
+    return executed;
+}
+
+#endif
@@ -0,0 +1,14 @@
+#ifdef KRYOS_RHI_NULL
+
+#    include "RHI/Context.h"
+
+void RenderHardwareContext::InitializeRHI()
+{
+}
+
+RenderStateCounters RenderHardwareContext::StateCounters() const
+{
+    return RenderStateCounters {.Issued = 0, .Skipped = 0};
+}
+
+#endif
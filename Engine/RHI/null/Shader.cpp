@@ -0,0 +1,27 @@
+#ifdef KRYOS_RHI_NULL
+
+#    include "RHI/Shader.h"
+
+// Nothing is compiled, every program gets a distinct non zero handle so bind tracking still works
+static RenderHandle s_NextProgram = 1;
+
+bool ShaderCache::_QueryDriver()
+{
+    DriverHash = 0;
+    return false;
+}
+
+bool Shader::Initialize(const ShaderProgramDesc& desc, ShaderCache* cache)
+{
+    Key       = cache != nullptr ? cache->Key(desc) : 0;
+    FromCache = false;
+    Program   = s_NextProgram++;
+    return true;
+}
+
+void Shader::Destroy()
+{
+    Program = 0;
+}
+
+#endif
@@ -0,0 +1,18 @@
+#ifdef KRYOS_RHI_NULL
+
+#    include "RHI/StaticBatch.h"
+
+static RenderHandle s_NextBuffer = 1;
+
+bool StaticGeometryPool::_CreateBuffers()
+{
+    VertexBuffer = s_NextBuffer++;
+    IndexBuffer  = s_NextBuffer++;
+    return true;
+}
+
+void StaticGeometryPool::_DestroyBuffers()
+{
+}
+
+#endif
@@ -0,0 +1,36 @@
+#ifdef KRYOS_RHI_NULL
+
+#    include "RHI/UploadRing.h"
+
+// Plain host memory with nothing to fence, so the allocator itself can still be timed and
+// exercised without a driver
+static RenderHandle s_NextBuffer = 1;
+
+void RenderUploadRing::_QueryLimits()
+{
+    UniformAlignment = 256;
+    StorageAlignment = 256;
+}
+
+bool RenderUploadRing::_CreateBuffer()
+{
+    Buffer = s_NextBuffer++;
+    Mapped = new uint8_t[FrameSize * FrameCount];
+    return true;
+}
+
+void RenderUploadRing::_DestroyBuffer()
+{
+    delete[] Mapped;
+}
+
+bool RenderUploadRing::_WaitFence(uint32_t)
+{
+    return false;
+}
+
+void RenderUploadRing::_InsertFence(uint32_t)
+{
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifdef KRYOS_RHI_NULL
+
+#    include "RHI/WindowHandle.h"
+#    include "Core/Console.h"
+#    include "Core/Profiler.h"
+
+// GLFW runs on its null platform (see WindowHandle::InitializeGLFW), so windows, input callbacks
+// and event polling behave as usual without a display, there just isn't any graphics API
+
+void WindowHandle::Initialize(const std::string_view& title, int width, int height, int flags)
+{
+    RHI_CONDITION_FATAL(title[title.size()] == '\0', "Title string must be null terminated");
+    RHI_CONDITION_FATAL(ValidMode(flags),
+                        "Can only create window with one or none of the window modes");
+
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    glfwWindowHint(GLFW_VISIBLE, (flags & WindowHandle_HiddenBit) == 0);
+    glfwWindowHint(GLFW_FOCUSED, GLFW_TRUE);
+
+    if (width < 0 || height < 0) {
+        width  = 1280;
+        height = 720;
+    }
+
+    GLFWwindow* window = glfwCreateWindow(width, height, title.data(), nullptr, nullptr);
+    RHI_CONDITION_FATAL(window != nullptr, "Failed to create null GLFW window");
+
+    WindowPtr = window;
+    Flags     = flags;
+    RHI_INFO("Using the null RHI backend, nothing will be rendered");
+}
+
+void WindowHandle::Destroy()
+{
+    RHI_CONDITION_ERROR(WindowPtr != nullptr, "WindowHandle is nullptr, Cannot destroy window");
+    glfwDestroyWindow(WindowPtr);
+    WindowPtr = nullptr;
+    Flags     = 0;
+}
+
+void WindowHandle::SwapBuffers()
+{
+    PROFILE_SCOPE("WindowHandle::SwapBuffers");
+}
+
+void WindowHandle::SetVsync(bool vsync, bool adaptive)
+{
+    Flags &= ~(WindowHandle_VsyncBit | WindowHandle_AdaptiveVsyncBit);
+    Flags |= (vsync ? WindowHandle_VsyncBit : 0) | (adaptive ? WindowHandle_AdaptiveVsyncBit : 0);
+}
+
+void WindowHandle::MakeCurrentContext() const
+{
+}
+
+void WindowHandle::ClearCurrentContext()
+{
+}
+
+#endif
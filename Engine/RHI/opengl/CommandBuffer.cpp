@@ -0,0 +1,98 @@
+#ifdef KRYOS_RHI_OPENGL
+
+#    include "RHI/CommandBuffer.h"
+#    include "RHI/opengl/Context.h"
+#    include <glad/glad.h>
+
+template <typename TCommand>
+static TCommand ReadCommand(const uint8_t* packet)
+{
+    TCommand command;
+    std::memcpy(&command, packet + RenderCommandHeader::PayloadOffset, sizeof(TCommand));
+    return command;
+}
+
+static void ExecuteBindBuffer(OpenGLStateCache& state, const RenderCommandBindBuffer& command)
+{
+    switch (command.Target) {
+    case RenderBufferTarget_Vertex:
+        state.BindVertexBuffer(command.Slot, command.Buffer, (GLintptr)command.Offset,
+                               (GLsizei)command.Stride);
+        break;
+    case RenderBufferTarget_Index:
+        state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, command.Buffer);
+        break;
+    case RenderBufferTarget_Uniform:
+    case RenderBufferTarget_Storage: {
+        GLenum target = command.Target == RenderBufferTarget_Uniform ? GL_UNIFORM_BUFFER
+                                                                     : GL_SHADER_STORAGE_BUFFER;
+        state.BindBufferRange(target, command.Slot, command.Buffer, (GLintptr)command.Offset,
+                              (GLsizeiptr)command.Size);
+        break;
+    }
+    case RenderBufferTarget_Indirect:
+        state.BindBuffer(GL_DRAW_INDIRECT_BUFFER, command.Buffer);
+        break;
+    }
+}
+
+uint32_t RenderCommandBuffer::Execute() const
+{
+    OpenGLStateCache& state = OpenGLStateCache::Get();
+    uint32_t executed       = 0;
+    const uint8_t* packet   = Data.data();
+    const uint8_t* end      = packet + Data.size();
+    while (packet < end) {
+        RenderCommandHeader header;
+        std::memcpy(&header, packet, sizeof(header));
+
+        switch (header.Type) {
+        case RenderCommandType_BindPipeline:
+            state.UseProgram(ReadCommand<RenderCommandBindPipeline>(packet).Program);
+            break;
+        case RenderCommandType_BindVertexArray:
+            state.BindVertexArray(ReadCommand<RenderCommandBindVertexArray>(packet).VertexArray);
+            break;
+        case RenderCommandType_BindBuffer:
+            ExecuteBindBuffer(state, ReadCommand<RenderCommandBindBuffer>(packet));
+            break;
+        case RenderCommandType_Draw: {
+            auto command = ReadCommand<RenderCommandDraw>(packet);
+            glDrawArraysInstancedBaseInstance(GL_TRIANGLES, (GLint)command.FirstVertex,
+                                              (GLsizei)command.VertexCount,
+                                              (GLsizei)command.InstanceCount,
+                                              command.FirstInstance);
+            break;
+        }
+        case RenderCommandType_DrawIndexed: {
+            auto command     = ReadCommand<RenderCommandDrawIndexed>(packet);
+            bool u16         = command.IndexType == RenderIndexType_U16;
+            uintptr_t offset = (uintptr_t)command.FirstIndex * (u16 ? 2 : 4);
+            glDrawElementsInstancedBaseVertexBaseInstance(
+                GL_TRIANGLES, (GLsizei)command.IndexCount,
+                u16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (const void*)offset,
+                (GLsizei)command.InstanceCount, command.BaseVertex, command.FirstInstance);
+            break;
+        }
+        case RenderCommandType_DrawIndexedIndirect: {
+            auto command = ReadCommand<RenderCommandDrawIndexedIndirect>(packet);
+            bool u16     = command.IndexType == RenderIndexType_U16;
+            glMultiDrawElementsIndirect(GL_TRIANGLES, u16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT,
+                                        (const void*)(uintptr_t)command.Offset,
+                                        (GLsizei)command.DrawCount, (GLsizei)command.Stride);
+            break;
+        }
+        case RenderCommandType_Dispatch: {
+            auto command = ReadCommand<RenderCommandDispatch>(packet);
+            glDispatchCompute(command.GroupsX, command.GroupsY, command.GroupsZ);
+            break;
+        }
+        }
+
+        packet += header.Size;
+        executed++;
+    }
+    return executed;
+}
+
+#endif
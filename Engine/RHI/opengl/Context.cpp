@@ -0,0 +1,270 @@
+#ifdef KRYOS_RHI_OPENGL
+
+#    include "RHI/opengl/Context.h"
+#    include "RHI/Context.h"
+#    include "Core/Profiler.h"
+
+// GL state belongs to the single context created by WindowHandle, used by whichever thread has it
+// current
+static OpenGLStateCache s_StateCache;
+
+static void SetEnabled(GLenum capability, bool enabled)
+{
+    if (enabled) {
+        glEnable(capability);
+    }
+    else {
+        glDisable(capability);
+    }
+}
+
+void RenderHardwareContext::InitializeRHI()
+{
+    s_StateCache.Invalidate();
+    s_StateCache.IssuedCount  = 0;
+    s_StateCache.SkippedCount = 0;
+}
+
+RenderStateCounters RenderHardwareContext::StateCounters() const
+{
+    return RenderStateCounters {
+        .Issued  = s_StateCache.IssuedCount + s_StateCache.FrameIssued,
+        .Skipped = s_StateCache.SkippedCount + s_StateCache.FrameSkipped,
+    };
+}
+
+OpenGLStateCache& OpenGLStateCache::Get()
+{
+    return s_StateCache;
+}
+
+void OpenGLStateCache::Invalidate()
+{
+    Program        = Unknown;
+    VertexArray    = Unknown;
+    ArrayBuffer    = Unknown;
+    ElementBuffer  = Unknown;
+    IndirectBuffer = Unknown;
+    for (uint32_t unit = 0; unit < TextureUnitCount; unit++) {
+        Textures[unit] = Unknown;
+        Samplers[unit] = Unknown;
+    }
+    for (uint32_t slot = 0; slot < BufferSlotCount; slot++) {
+        UniformBuffers[slot] = OpenGLIndexedBuffer {Unknown, 0, 0};
+        StorageBuffers[slot] = OpenGLIndexedBuffer {Unknown, 0, 0};
+    }
+    for (uint32_t slot = 0; slot < VertexBufferCount; slot++) {
+        VertexBuffers[slot] = OpenGLVertexBuffer {Unknown, 0, 0};
+    }
+    BlendKnown  = false;
+    DepthKnown  = false;
+    RasterKnown = false;
+}
+
+void OpenGLStateCache::DeleteBuffers(GLsizei count, const GLuint* buffers)
+{
+    glDeleteBuffers(count, buffers);
+    for (GLsizei i = 0; i < count; i++) {
+        GLuint buffer = buffers[i];
+        auto forget   = [&](GLuint& bound) {
+            if (bound == buffer) {
+                bound = Unknown;
+            }
+        };
+        forget(ArrayBuffer);
+        forget(ElementBuffer);
+        forget(IndirectBuffer);
+        for (uint32_t slot = 0; slot < BufferSlotCount; slot++) {
+            forget(UniformBuffers[slot].Buffer);
+            forget(StorageBuffers[slot].Buffer);
+        }
+        for (uint32_t slot = 0; slot < VertexBufferCount; slot++) {
+            forget(VertexBuffers[slot].Buffer);
+        }
+    }
+}
+
+void OpenGLStateCache::EndFrame()
+{
+    PROFILE_COUNTER("GL Calls Issued", FrameIssued);
+    PROFILE_COUNTER("GL Calls Skipped", FrameSkipped);
+    IssuedCount += FrameIssued;
+    SkippedCount += FrameSkipped;
+
+    FrameIssued  = 0;
+    FrameSkipped = 0;
+}
+
+void OpenGLStateCache::UseProgram(GLuint program)
+{
+    if (!_Skip(Program == program)) {
+        Program = program;
+        glUseProgram(program);
+    }
+}
+
+void OpenGLStateCache::BindVertexArray(GLuint vertex_array)
+{
+    if (_Skip(VertexArray == vertex_array)) {
+        return;
+    }
+    VertexArray   = vertex_array;
+    ElementBuffer = Unknown;
+    for (uint32_t slot = 0; slot < VertexBufferCount; slot++) {
+        VertexBuffers[slot].Buffer = Unknown;
+    }
+    glBindVertexArray(vertex_array);
+}
+
+void OpenGLStateCache::BindBuffer(GLenum target, GLuint buffer)
+{
+    GLuint* bound = nullptr;
+    switch (target) {
+    case GL_ARRAY_BUFFER:
+        bound = &ArrayBuffer;
+        break;
+    case GL_ELEMENT_ARRAY_BUFFER:
+        bound = &ElementBuffer;
+        break;
+    case GL_DRAW_INDIRECT_BUFFER:
+        bound = &IndirectBuffer;
+        break;
+    }
+
+    if (bound == nullptr) {
+        FrameIssued++;
+        glBindBuffer(target, buffer);
+    }
+    else if (!_Skip(*bound == buffer)) {
+        *bound = buffer;
+        glBindBuffer(target, buffer);
+    }
+}
+
+void OpenGLStateCache::BindBufferRange(GLenum target, GLuint slot, GLuint buffer, GLintptr offset,
+                                       GLsizeiptr size)
+{
+    OpenGLIndexedBuffer* bound = nullptr;
+    if (slot < BufferSlotCount) {
+        if (target == GL_UNIFORM_BUFFER) {
+            bound = &UniformBuffers[slot];
+        }
+        else if (target == GL_SHADER_STORAGE_BUFFER) {
+            bound = &StorageBuffers[slot];
+        }
+    }
+
+    if (bound != nullptr) {
+        if (_Skip(bound->Buffer == buffer && bound->Offset == offset && bound->Size == size)) {
+            return;
+        }
+        *bound = OpenGLIndexedBuffer {buffer, offset, size};
+    }
+    else {
+        FrameIssued++;
+    }
+
+    if (size == 0) {
+        glBindBufferBase(target, slot, buffer);
+    }
+    else {
+        glBindBufferRange(target, slot, buffer, offset, size);
+    }
+}
+
+void OpenGLStateCache::BindVertexBuffer(GLuint slot, GLuint buffer, GLintptr offset,
+                                        GLsizei stride)
+{
+    if (slot >= VertexBufferCount) {
+        FrameIssued++;
+        glBindVertexBuffer(slot, buffer, offset, stride);
+        return;
+    }
+
+    OpenGLVertexBuffer& bound = VertexBuffers[slot];
+    if (!_Skip(bound.Buffer == buffer && bound.Offset == offset && bound.Stride == stride)) {
+        bound = OpenGLVertexBuffer {buffer, offset, stride};
+        glBindVertexBuffer(slot, buffer, offset, stride);
+    }
+}
+
+void OpenGLStateCache::BindTexture(GLuint unit, GLuint texture)
+{
+    if (unit >= TextureUnitCount) {
+        FrameIssued++;
+        glBindTextureUnit(unit, texture);
+    }
+    else if (!_Skip(Textures[unit] == texture)) {
+        Textures[unit] = texture;
+        glBindTextureUnit(unit, texture);
+    }
+}
+
+void OpenGLStateCache::BindSampler(GLuint unit, GLuint sampler)
+{
+    if (unit >= TextureUnitCount) {
+        FrameIssued++;
+        glBindSampler(unit, sampler);
+    }
+    else if (!_Skip(Samplers[unit] == sampler)) {
+        Samplers[unit] = sampler;
+        glBindSampler(unit, sampler);
+    }
+}
+
+void OpenGLStateCache::SetBlend(const OpenGLBlendState& state)
+{
+    bool known = BlendKnown;
+    if (!_Skip(known && Blend.Enabled == state.Enabled)) {
+        SetEnabled(GL_BLEND, state.Enabled);
+    }
+    if (!_Skip(known && Blend.SrcColor == state.SrcColor && Blend.DstColor == state.DstColor &&
+               Blend.SrcAlpha == state.SrcAlpha && Blend.DstAlpha == state.DstAlpha)) {
+        glBlendFuncSeparate(state.SrcColor, state.DstColor, state.SrcAlpha, state.DstAlpha);
+    }
+    if (!_Skip(known && Blend.ColorOp == state.ColorOp && Blend.AlphaOp == state.AlphaOp)) {
+        glBlendEquationSeparate(state.ColorOp, state.AlphaOp);
+    }
+    Blend      = state;
+    BlendKnown = true;
+}
+
+void OpenGLStateCache::SetDepth(const OpenGLDepthState& state)
+{
+    bool known = DepthKnown;
+    if (!_Skip(known && Depth.TestEnabled == state.TestEnabled)) {
+        SetEnabled(GL_DEPTH_TEST, state.TestEnabled);
+    }
+    if (!_Skip(known && Depth.WriteEnabled == state.WriteEnabled)) {
+        glDepthMask(state.WriteEnabled ? GL_TRUE : GL_FALSE);
+    }
+    if (!_Skip(known && Depth.Function == state.Function)) {
+        glDepthFunc(state.Function);
+    }
+    Depth      = state;
+    DepthKnown = true;
+}
+
+void OpenGLStateCache::SetRaster(const OpenGLRasterState& state)
+{
+    bool known = RasterKnown;
+    if (!_Skip(known && Raster.CullEnabled == state.CullEnabled)) {
+        SetEnabled(GL_CULL_FACE, state.CullEnabled);
+    }
+    if (!_Skip(known && Raster.CullFace == state.CullFace)) {
+        glCullFace(state.CullFace);
+    }
+    if (!_Skip(known && Raster.FrontFace == state.FrontFace)) {
+        glFrontFace(state.FrontFace);
+    }
+    if (!_Skip(known && Raster.PolygonMode == state.PolygonMode)) {
+        glPolygonMode(GL_FRONT_AND_BACK, state.PolygonMode);
+    }
+    if (!_Skip(known && Raster.ScissorEnabled == state.ScissorEnabled)) {
+        SetEnabled(GL_SCISSOR_TEST, state.ScissorEnabled);
+    }
+    Raster      = state;
+    RasterKnown = true;
+}
+
+#endif
@@ -0,0 +1,111 @@
+#pragma once
+
+#ifdef KRYOS_RHI_OPENGL
+
+#    include <cstdint>
+#    include <glad/glad.h>
+
+struct OpenGLBlendState {
+    bool Enabled    = false;
+    GLenum SrcColor = GL_ONE;
+    GLenum DstColor = GL_ZERO;
+    GLenum SrcAlpha = GL_ONE;
+    GLenum DstAlpha = GL_ZERO;
+    GLenum ColorOp  = GL_FUNC_ADD;
+    GLenum AlphaOp  = GL_FUNC_ADD;
+};
+
+struct OpenGLDepthState {
+    bool TestEnabled  = false;
+    bool WriteEnabled = true;
+    GLenum Function   = GL_LESS;
+};
+
+struct OpenGLRasterState {
+    bool CullEnabled    = false;
+    GLenum CullFace     = GL_BACK;
+    GLenum FrontFace    = GL_CCW;
+    GLenum PolygonMode  = GL_FILL;
+    bool ScissorEnabled = false;
+};
+
+struct OpenGLIndexedBuffer {
+    GLuint Buffer;
+    GLintptr Offset;
+    GLsizeiptr Size; // 0 when bound with glBindBufferBase
+};
+
+struct OpenGLVertexBuffer {
+    GLuint Buffer;
+    GLintptr Offset;
+    GLsizei Stride;
+};
+
+// Shadow copy of the GL state changed through the engine, so binding what is already bound never
+// reaches the driver. Anything touching GL directly must call Invalidate afterwards. Element array
+// and vertex buffer bindings belong to the bound vertex array, so they are forgotten whenever the
+// vertex array changes
+struct OpenGLStateCache {
+    static constexpr GLuint Unknown             = ~0u;
+    static constexpr uint32_t TextureUnitCount  = 32;
+    static constexpr uint32_t BufferSlotCount   = 16;
+    static constexpr uint32_t VertexBufferCount = 16;
+
+    GLuint Program;
+    GLuint VertexArray;
+    GLuint ArrayBuffer;
+    GLuint ElementBuffer;
+    GLuint IndirectBuffer;
+    GLuint Textures[TextureUnitCount];
+    GLuint Samplers[TextureUnitCount];
+    OpenGLIndexedBuffer UniformBuffers[BufferSlotCount];
+    OpenGLIndexedBuffer StorageBuffers[BufferSlotCount];
+    OpenGLVertexBuffer VertexBuffers[VertexBufferCount];
+
+    bool BlendKnown;
+    bool DepthKnown;
+    bool RasterKnown;
+    OpenGLBlendState Blend;
+    OpenGLDepthState Depth;
+    OpenGLRasterState Raster;
+
+    // Running totals, FrameIssued/FrameSkipped are sent to the profiler and cleared by EndFrame
+    uint64_t IssuedCount  = 0;
+    uint64_t SkippedCount = 0;
+    uint32_t FrameIssued  = 0;
+    uint32_t FrameSkipped = 0;
+
+    static OpenGLStateCache& Get();
+
+    void Invalidate();
+    void EndFrame();
+
+    // Deletes the buffers and forgets only the cached bindings naming them, GL unbinds them
+    void DeleteBuffers(GLsizei count, const GLuint* buffers);
+
+    void UseProgram(GLuint program);
+    void BindVertexArray(GLuint vertex_array);
+    void BindBuffer(GLenum target, GLuint buffer);
+    void BindBufferRange(GLenum target, GLuint slot, GLuint buffer, GLintptr offset = 0,
+                         GLsizeiptr size = 0);
+    void BindVertexBuffer(GLuint slot, GLuint buffer, GLintptr offset, GLsizei stride);
+    void BindTexture(GLuint unit, GLuint texture);
+    void BindSampler(GLuint unit, GLuint sampler);
+
+    void SetBlend(const OpenGLBlendState& state);
+    void SetDepth(const OpenGLDepthState& state);
+    void SetRaster(const OpenGLRasterState& state);
+
+private:
+    inline bool _Skip(bool redundant)
+    {
+        if (redundant) {
+            FrameSkipped++;
+            return true;
+        }
+        FrameIssued++;
+        return false;
+    }
+};
+
+#endif
@@ -0,0 +1,193 @@
+#ifdef KRYOS_RHI_OPENGL
+
+#    include "RHI/opengl/Shader.h"
+#    include "Core/Console.h"
+#    include "Core/Hash.h"
+#    include "Core/Profiler.h"
+#    include <string>
+
+static std::string InfoLog(GLuint object, bool program)
+{
+    GLint length = 0;
+    if (program) {
+        glGetProgramiv(object, GL_INFO_LOG_LENGTH, &length);
+    }
+    else {
+        glGetShaderiv(object, GL_INFO_LOG_LENGTH, &length);
+    }
+
+    std::string log(length > 0 ? (size_t)length : 0, '\0');
+    if (length > 0 && program) {
+        glGetProgramInfoLog(object, length, nullptr, log.data());
+    }
+    else if (length > 0) {
+        glGetShaderInfoLog(object, length, nullptr, log.data());
+    }
+    while (!log.empty() && (log.back() == '\0' || log.back() == '\n')) {
+        log.pop_back();
+    }
+    return log;
+}
+
+GLenum OpenGLShaderStage(ShaderStage stage)
+{
+    switch (stage) {
+    case ShaderStage_Vertex:
+        return GL_VERTEX_SHADER;
+    case ShaderStage_Fragment:
+        return GL_FRAGMENT_SHADER;
+    case ShaderStage_Geometry:
+        return GL_GEOMETRY_SHADER;
+    case ShaderStage_Compute:
+        return GL_COMPUTE_SHADER;
+    }
+    return GL_NONE;
+}
+
+GLuint OpenGLCompileShader(GLenum stage, const std::string& source, std::string_view name)
+{
+    GLuint shader     = glCreateShader(stage);
+    const char* data  = source.c_str();
+    GLint data_length = (GLint)source.size();
+    glShaderSource(shader, 1, &data, &data_length);
+    glCompileShader(shader);
+
+    GLint status = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE) {
+        RHI_ERROR("Failed to compile '{}' stage 0x{:x}:\n{}", name, stage, InfoLog(shader, false));
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+GLuint OpenGLLinkProgram(const GLuint* shaders, size_t count, std::string_view name,
+                         bool retrievable)
+{
+    GLuint program = glCreateProgram();
+    if (retrievable) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    for (size_t i = 0; i < count; i++) {
+        glAttachShader(program, shaders[i]);
+    }
+    glLinkProgram(program);
+    for (size_t i = 0; i < count; i++) {
+        glDetachShader(program, shaders[i]);
+    }
+
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        RHI_ERROR("Failed to link '{}':\n{}", name, InfoLog(program, true));
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+static GLuint LoadProgramBinary(const ShaderCache& cache, uint64_t key)
+{
+    uint32_t format = 0;
+    std::vector<uint8_t> binary;
+    if (!cache.Load(key, format, binary)) {
+        return 0;
+    }
+
+    // Drivers may reject binaries after an update that does not change the version string
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, format, binary.data(), (GLsizei)binary.size());
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+static void StoreProgramBinary(const ShaderCache& cache, uint64_t key, GLuint program)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    GLenum format = 0;
+    std::vector<uint8_t> binary((size_t)length);
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+    binary.resize((size_t)length);
+    cache.Store(key, format, binary);
+}
+
+bool ShaderCache::_QueryDriver()
+{
+    GLint format_count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+
+    DriverHash = HashSeed;
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        const char* str = (const char*)glGetString(name);
+        DriverHash      = HashString(str != nullptr ? str : "", DriverHash);
+    }
+    RHI_CONDITION_WARN_RETURN(format_count > 0, false,
+                              "Driver exposes no program binary formats, shader cache disabled");
+    return true;
+}
+
+bool Shader::Initialize(const ShaderProgramDesc& desc, ShaderCache* cache)
+{
+    PROFILE_FUNCTION();
+    bool cached = cache != nullptr && cache->Enabled;
+    Key         = cached ? cache->Key(desc) : 0;
+    FromCache   = false;
+
+    if (cached) {
+        Program = LoadProgramBinary(*cache, Key);
+        if (Program != 0) {
+            cache->HitCount++;
+            FromCache = true;
+            return true;
+        }
+        cache->MissCount++;
+    }
+
+    std::vector<GLuint> shaders;
+    shaders.reserve(desc.Stages.size());
+    for (const ShaderStageSource& stage : desc.Stages) {
+        GLuint shader = OpenGLCompileShader(OpenGLShaderStage(stage.Stage),
+                                            ComposeSource(stage.Source, desc.Defines), desc.Name);
+        if (shader == 0) {
+            break;
+        }
+        shaders.push_back(shader);
+    }
+
+    Program = 0;
+    if (shaders.size() == desc.Stages.size()) {
+        Program = OpenGLLinkProgram(shaders.data(), shaders.size(), desc.Name, cached);
+    }
+    for (GLuint shader : shaders) {
+        glDeleteShader(shader);
+    }
+    if (Program == 0) {
+        return false;
+    }
+
+    if (cached) {
+        StoreProgramBinary(*cache, Key, Program);
+    }
+    return true;
+}
+
+void Shader::Destroy()
+{
+    if (Program != 0) {
+        glDeleteProgram(Program);
+        Program = 0;
+    }
+}
+
+#endif
@@ -0,0 +1,15 @@
+#pragma once
+
+#ifdef KRYOS_RHI_OPENGL
+
+#    include "RHI/Shader.h"
+#    include <glad/glad.h>
+
+GLenum OpenGLShaderStage(ShaderStage stage);
+
+// Both return 0 and log the driver info log on failure
+GLuint OpenGLCompileShader(GLenum stage, const std::string& source, std::string_view name);
+GLuint OpenGLLinkProgram(const GLuint* shaders, size_t count, std::string_view name,
+                         bool retrievable);
+
+#endif
@@ -0,0 +1,31 @@
+#ifdef KRYOS_RHI_OPENGL
+
+#    include "RHI/StaticBatch.h"
+#    include "RHI/opengl/Context.h"
+#    include "Core/Console.h"
+#    include <glad/glad.h>
+
+bool StaticGeometryPool::_CreateBuffers()
+{
+    // The context is created as 4.5, which only has gl_BaseInstance through the extension
+    RHI_CONDITION_ERROR_RETURN(GLAD_GL_VERSION_4_6 || GLAD_GL_ARB_shader_draw_parameters, false,
+                               "Static batches need OpenGL 4.6 or ARB_shader_draw_parameters to "
+                               "index instance data with gl_BaseInstance");
+
+    GLuint buffers[2] = {};
+    glCreateBuffers(2, buffers);
+    glNamedBufferStorage(buffers[0], (GLsizeiptr)Vertices.size(), Vertices.data(), 0);
+    glNamedBufferStorage(buffers[1], (GLsizeiptr)(Indices.size() * sizeof(uint32_t)),
+                         Indices.data(), 0);
+    VertexBuffer = buffers[0];
+    IndexBuffer  = buffers[1];
+    return true;
+}
+
+void StaticGeometryPool::_DestroyBuffers()
+{
+    GLuint buffers[2] = {VertexBuffer, IndexBuffer};
+    OpenGLStateCache::Get().DeleteBuffers(2, buffers);
+}
+
+#endif
@@ -0,0 +1,85 @@
+#ifdef KRYOS_RHI_OPENGL
+
+#    include "RHI/UploadRing.h"
+#    include "Core/Console.h"
+#    include "Core/Profiler.h"
+#    include "RHI/opengl/Context.h"
+#    include <glad/glad.h>
+
+// Coherent persistent mapping, writes become visible to the GPU without flushes or unmapping so
+// the only synchronization left is the per region fence
+static constexpr GLbitfield s_MapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                                         GL_MAP_COHERENT_BIT;
+
+// Spins on one second timeouts so a lost fence shows up in the log instead of hanging silently
+static constexpr GLuint64 s_WaitTimeout = 1000000000;
+
+void RenderUploadRing::_QueryLimits()
+{
+    GLint uniform_alignment = 0;
+    GLint storage_alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_alignment);
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storage_alignment);
+    UniformAlignment = uniform_alignment > 0 ? (uint32_t)uniform_alignment : 256;
+    StorageAlignment = storage_alignment > 0 ? (uint32_t)storage_alignment : 256;
+}
+
+bool RenderUploadRing::_CreateBuffer()
+{
+    GLsizeiptr size = (GLsizeiptr)(FrameSize * FrameCount);
+    GLuint buffer   = 0;
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, size, nullptr, s_MapFlags);
+
+    void* mapped = glMapNamedBufferRange(buffer, 0, size, s_MapFlags);
+    if (mapped == nullptr) {
+        glDeleteBuffers(1, &buffer);
+        RHI_ERROR_RETURN(false, "Failed to persistently map {} byte upload ring", size);
+    }
+    Buffer = buffer;
+    Mapped = (uint8_t*)mapped;
+    return true;
+}
+
+void RenderUploadRing::_DestroyBuffer()
+{
+    glUnmapNamedBuffer(Buffer);
+    OpenGLStateCache::Get().DeleteBuffers(1, &Buffer);
+}
+
+bool RenderUploadRing::_WaitFence(uint32_t frame)
+{
+    GLsync fence = (GLsync)Fences[frame];
+    if (fence == nullptr) {
+        return false;
+    }
+
+    bool stalled  = false;
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        PROFILE_SCOPE("Upload Ring Stall");
+        stalled = true;
+        result  = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, s_WaitTimeout);
+        while (result == GL_TIMEOUT_EXPIRED) {
+            RHI_WARN("Upload ring region {} still in use after a second", frame);
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, s_WaitTimeout);
+        }
+    }
+    if (result == GL_WAIT_FAILED) {
+        RHI_WARN("Waiting on upload ring region {} failed", frame);
+    }
+
+    glDeleteSync(fence);
+    Fences[frame] = nullptr;
+    return stalled;
+}
+
+void RenderUploadRing::_InsertFence(uint32_t frame)
+{
+    if (Fences[frame] != nullptr) {
+        glDeleteSync((GLsync)Fences[frame]);
+    }
+    Fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+#endif
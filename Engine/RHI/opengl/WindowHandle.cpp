@@ -1,7 +1,9 @@
 #ifdef KRYOS_RHI_OPENGL
 
 #    include "RHI/WindowHandle.h"
+#    include "RHI/opengl/Context.h"
 #    include "Core/Console.h"
+#    include "Core/Profiler.h"
 #    include <glad/glad.h>
 
 static bool s_GladInitialized = false;
@@ -19,6 +21,7 @@ void WindowHandle::Initialize(const std::string_view& title, int width, int heig
     glfwWindowHint(GLFW_RESIZABLE, (flags & WindowHandle_ResizeableBit) != 0);
     glfwWindowHint(GLFW_DECORATED, (flags & ~WindowHandle_BorderlessModeBit) != 0);
     glfwWindowHint(GLFW_TRANSPARENT_FRAMEBUFFER, (flags & WindowHandle_TransparentBufferBit) != 0);
+    glfwWindowHint(GLFW_VISIBLE, (flags & WindowHandle_HiddenBit) == 0);
 
     GLFWmonitor* monitor       = glfwGetPrimaryMonitor();
     const GLFWvidmode* vidmode = glfwGetVideoMode(monitor);
@@ -41,15 +44,9 @@ void WindowHandle::Initialize(const std::string_view& title, int width, int heig
                             "Failed to initialize GLAD");
     }
 
-    if (flags & WindowHandle_VsyncBit) {
-        glfwSwapInterval(0);
-    }
-    else {
-        glfwSwapInterval(1);
-    }
-
     WindowPtr = window;
     Flags     = flags;
+    SetVsync(flags & WindowHandle_VsyncBit, flags & WindowHandle_AdaptiveVsyncBit);
 }
 
 void WindowHandle::Destroy()
@@ -62,7 +59,41 @@ void WindowHandle::Destroy()
 
 void WindowHandle::SwapBuffers()
 {
+    PROFILE_SCOPE("WindowHandle::SwapBuffers");
+    OpenGLStateCache::Get().EndFrame();
     glfwSwapBuffers(WindowPtr);
 }
 
+void WindowHandle::SetVsync(bool vsync, bool adaptive)
+{
+    // Swap interval applies to the current context
+    glfwMakeContextCurrent(WindowPtr);
+
+    int interval = vsync ? 1 : 0;
+    if (vsync && adaptive) {
+        if (glfwExtensionSupported("WGL_EXT_swap_control_tear") ||
+            glfwExtensionSupported("GLX_EXT_swap_control_tear")) {
+            interval = -1;
+        }
+        else {
+            RHI_WARN("Adaptive vsync is not supported, falling back to regular vsync");
+            adaptive = false;
+        }
+    }
+    glfwSwapInterval(interval);
+
+    Flags &= ~(WindowHandle_VsyncBit | WindowHandle_AdaptiveVsyncBit);
+    Flags |= (vsync ? WindowHandle_VsyncBit : 0) | (adaptive ? WindowHandle_AdaptiveVsyncBit : 0);
+}
+
+void WindowHandle::MakeCurrentContext() const
+{
+    glfwMakeContextCurrent(WindowPtr);
+}
+
+void WindowHandle::ClearCurrentContext()
+{
+    glfwMakeContextCurrent(nullptr);
+}
+
 #endif
@@ -0,0 +1,177 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Core/Console.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fmt/color.h>
+#include <new>
+
+// Formats the same messages through the previous string returning implementation and through
+// ConsoleOutput::_FormatHead/_FormatBody, reporting time and heap allocations per message
+
+static std::atomic<uint64_t> s_AllocationCount {0};
+
+void* operator new(size_t size)
+{
+    s_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+struct BenchmarkOutput : public ConsoleOutput {
+    void Initialize(uint32_t flags = ConsoleOutput_NoneBit) override { Flags = flags; }
+    inline void Destroy() override {}
+
+    inline std::string_view Name() const override { return "Benchmark Output"; }
+    void PrintOutput(const ConsoleMessage& msg) override
+    {
+        Buffer.clear();
+        _FormatHead(msg, Buffer);
+        _FormatBody(msg, Buffer);
+        Buffer.push_back('\n');
+    }
+
+    // Previous implementation, unchanged apart from line wrapping, kept here only as the baseline
+    std::string LegacyFormatHead(const ConsoleMessage& msg)
+    {
+        fmt::text_style style;
+        if (Flags & ConsoleOutput_ColorBit) {
+            switch (msg.SeverityFlag) {
+            case ConsoleMessage::Trace:
+                style = fmt::fg(fmt::color::dim_gray);
+                break;
+            case ConsoleMessage::Verbose:
+                style = fmt::fg(fmt::color::dim_gray);
+                break;
+            case ConsoleMessage::Info:
+                style = fmt::fg(fmt::color::sky_blue);
+                break;
+            case ConsoleMessage::Warning:
+                style = fmt::emphasis::italic | fmt::fg(fmt::color::yellow);
+                break;
+            case ConsoleMessage::Error:
+                style = fmt::emphasis::italic | fmt::emphasis::bold |
+                        fmt::fg(fmt::color::orange_red);
+                break;
+            case ConsoleMessage::Fatal:
+                style = fmt::emphasis::italic | fmt::fg(fmt::color::white) |
+                        fmt::bg(fmt::color::dark_red);
+                break;
+            default:
+                break;
+            }
+        }
+
+        if (msg.Context != nullptr) {
+            return fmt::format(style, "{} [{}]",
+                               ConsoleMessage::SeverityFlagToCString(msg.SeverityFlag),
+                               msg.Context);
+        }
+        else {
+            return fmt::format(style, "{}",
+                               ConsoleMessage::SeverityFlagToCString(msg.SeverityFlag));
+        }
+    }
+
+    std::string LegacyFormatBody(const ConsoleMessage& msg)
+    {
+        std::string body;
+        body.append(fmt::format("{}", (Flags & ConsoleOutput_BreakAfterHeaderBit) ? "\n" : " "));
+        bool include_meta_info = false;
+        if (msg.SeverityFlag > ConsoleMessage::Info) {
+            include_meta_info = true;
+            if (Flags & ~ConsoleOutput_FilterFileBit) {
+                body.append(fmt::format("file={} ", msg.File));
+            }
+            if (Flags & ~ConsoleOutput_FilterLineBit) {
+                body.append(fmt::format("line={} ", msg.Line));
+            }
+            if (Flags & ~ConsoleOutput_FilterFunctionBit) {
+                body.append(fmt::format("func={} ", msg.Function));
+            }
+        }
+        if (include_meta_info) {
+            body.append(fmt::format("{}{}", (Flags & ConsoleOutput_BreakAfterInfoBit) ? "\n" : "",
+                                    msg.Message));
+        }
+        else {
+            body.append(msg.Message);
+        }
+        return body;
+    }
+
+    void LegacyPrintOutput(const ConsoleMessage& msg)
+    {
+        Buffer.clear();
+        fmt::format_to(fmt::appender(Buffer), "{}{}\n", LegacyFormatHead(msg),
+                       LegacyFormatBody(msg));
+    }
+};
+
+template <typename TFunction>
+static void Run(const char* name, size_t iterations, TFunction&& function)
+{
+    uint64_t allocations = s_AllocationCount.load();
+    auto start           = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        function(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    fmt::println("{:<10} {:>10.1f} ns/msg {:>8.2f} allocs/msg", name, ns / iterations,
+                 (double)(s_AllocationCount.load() - allocations) / iterations);
+}
+
+int main(int argc, char** argv)
+{
+    size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+    const ConsoleMessage messages[] = {
+        {.Line         = 42,
+         .Message      = "Window resized to 1920x1080",
+         .File         = __FILE__,
+         .Function     = "main",
+         .Context      = nullptr,
+         .SeverityFlag = ConsoleMessage::Info},
+        {.Line         = 128,
+         .Message      = "`window != nullptr` == FALSE: Failed to create GLFW window",
+         .File         = __FILE__,
+         .Function     = "Initialize",
+         .Context      = "OPENGL",
+         .SeverityFlag = ConsoleMessage::Error},
+    };
+
+    BenchmarkOutput output;
+    output.Flags |= ConsoleOutput_ColorBit;
+    output.PrintOutput(messages[1]); // Warm up the buffer
+
+    Run("legacy", iterations, [&](size_t i) { output.LegacyPrintOutput(messages[i & 1]); });
+    Run("buffered", iterations, [&](size_t i) { output.PrintOutput(messages[i & 1]); });
+}
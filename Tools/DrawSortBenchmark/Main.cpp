@@ -0,0 +1,157 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Core/Console.h>
+#include <Core/JobSystem.h>
+#include <Core/Time.h>
+#include <RHI/Context.h>
+#include <RHI/DrawQueue.h>
+#include <algorithm>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <random>
+
+// Submits synthetic draws from job workers through RenderDrawQueue, then reports radix sort
+// time against std::sort and how many binds sorting saves over submission order. The sorted
+// commands are replayed into a hidden context to count the state changes the backend filters out,
+// the handles are synthetic so an OpenGL driver rejects the binds but the filtering is the same
+
+struct SyntheticDraw {
+    uint64_t Key;
+    RenderDraw Draw;
+};
+
+static std::vector<SyntheticDraw> GenerateDraws(uint32_t count)
+{
+    constexpr uint32_t shader_count   = 64;
+    constexpr uint32_t material_count = 1024;
+    constexpr uint32_t mesh_count     = 512;
+
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<uint32_t> shader_dist(0, shader_count - 1);
+    std::uniform_int_distribution<uint32_t> material_dist(0, material_count - 1);
+    std::uniform_real_distribution<float> depth_dist(0.0f, 1.0f);
+
+    std::vector<SyntheticDraw> draws(count);
+    for (SyntheticDraw& draw : draws) {
+        uint32_t shader   = shader_dist(rng);
+        uint32_t material = material_dist(rng);
+        bool translucent  = rng() % 5 == 0;
+        uint32_t pass     = translucent ? 1 : 0;
+
+        draw.Key  = RenderSortKey::Make(0, pass, translucent, shader, material, depth_dist(rng));
+        draw.Draw = RenderDraw {
+            .Program       = shader + 1,
+            .VertexArray   = material % mesh_count + 1, // Materials mostly stay on one mesh
+            .Material      = material + 1,
+            .IndexCount    = 36,
+            .FirstIndex    = 0,
+            .BaseVertex    = 0,
+            .InstanceCount = 1,
+            .FirstInstance = 0,
+            .IndexType     = RenderIndexType_U32,
+        };
+    }
+    return draws;
+}
+
+static bool Sorted(const std::vector<RenderSortItem>& items)
+{
+    return std::is_sorted(items.begin(), items.end(),
+                          [](const RenderSortItem& a, const RenderSortItem& b) {
+                              return a.Key < b.Key;
+                          });
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t draw_count = argc > 1 ? (uint32_t)std::strtoul(argv[1], nullptr, 10) : 100000;
+    uint32_t iterations = argc > 2 ? (uint32_t)std::strtoul(argv[2], nullptr, 10) : 20;
+
+    Console console;
+    console.Initialize();
+    console.AddOutput<ConsoleTerminalOutput>();
+    JobSystem jobs;
+    jobs.Initialize();
+    RenderHardwareContext context;
+    context.Initialize("KryosDrawSortBenchmark", 64, 64, WindowHandle_HiddenBit);
+
+    std::vector<SyntheticDraw> draws = GenerateDraws(draw_count);
+    RenderDrawQueue queue;
+    queue.Initialize(JobSystem::WorkerCount() + 1);
+
+    auto submit = [&](uint32_t begin, uint32_t end) {
+        RenderDrawBucket& bucket = queue.Local();
+        for (uint32_t i = begin; i < end; i++) {
+            bucket.Submit(draws[i].Key, draws[i].Draw);
+        }
+    };
+
+    uint64_t submit_ns        = 0;
+    uint64_t radix_ns         = 0;
+    uint64_t std_ns           = 0;
+    uint64_t execute_ns       = 0;
+    uint32_t unsorted_changes = 0;
+    uint32_t sorted_changes   = 0;
+    bool valid                = true;
+
+    for (uint32_t iteration = 0; iteration < iterations; iteration++) {
+        queue.Reset();
+        uint64_t start = Time::NowNanoseconds();
+        Job* job       = JobSystem::ParallelFor(draw_count, 1024, submit);
+        JobSystem::Run(job);
+        JobSystem::Wait(job);
+        submit_ns += Time::NowNanoseconds() - start;
+
+        queue.Build(false);
+        unsorted_changes = queue.StateChanges;
+
+        std::vector<RenderSortItem> items = queue.Items;
+        start                             = Time::NowNanoseconds();
+        std::stable_sort(items.begin(), items.end(),
+                         [](const RenderSortItem& a, const RenderSortItem& b) {
+                             return a.Key < b.Key;
+                         });
+        std_ns += Time::NowNanoseconds() - start;
+
+        queue.Build(true);
+        radix_ns += queue.SortNanoseconds;
+        sorted_changes = queue.StateChanges;
+        valid          = valid && Sorted(queue.Items);
+
+        start = Time::NowNanoseconds();
+        queue.Commands.Execute();
+        execute_ns += Time::NowNanoseconds() - start;
+    }
+
+    auto ms = [&](uint64_t ns) { return (double)ns / iterations / 1e6; };
+    fmt::println("{} draws, {} workers, {} iterations", draw_count, JobSystem::WorkerCount(),
+                 iterations);
+    fmt::println("{:<18} {:>8.3f} ms", "submit", ms(submit_ns));
+    fmt::println("{:<18} {:>8.3f} ms", "radix sort", ms(radix_ns));
+    fmt::println("{:<18} {:>8.3f} ms", "std::stable_sort", ms(std_ns));
+    fmt::println("{:<18} {:>8.3f} ms", "execute", ms(execute_ns));
+    fmt::println("{:<18} {:>8} -> {} ({:.1f}x fewer)", "state changes", unsorted_changes,
+                 sorted_changes, (double)unsorted_changes / std::max(sorted_changes, 1u));
+    RenderStateCounters counters = context.StateCounters();
+    fmt::println("{:<18} {:>8} issued {} skipped", "backend state", counters.Issued,
+                 counters.Skipped);
+    fmt::println("{:<18} {:>8}", "sorted", valid ? "yes" : "NO");
+
+    context.Destroy();
+    jobs.Destroy();
+    console.Destroy();
+    return valid ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Core/ConsoleBinaryFile.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+// Prints decoded messages with the same formatting the terminal output would have used
+struct DecoderOutput : public ConsoleOutput {
+    void Initialize(uint32_t flags = ConsoleOutput_NoneBit) override { Flags = flags; }
+    inline void Destroy() override {}
+
+    inline std::string_view Name() const override { return "Decoder Output"; }
+    void PrintOutput(const ConsoleMessage& msg) override
+    {
+        Buffer.clear();
+        _FormatHead(msg, Buffer);
+        _FormatBody(msg, Buffer);
+        Buffer.push_back('\n');
+        std::fwrite(Buffer.data(), 1, Buffer.size(), stdout);
+    }
+};
+
+int main(int argc, char** argv)
+{
+    bool color = false;
+    std::vector<std::unique_ptr<ConsoleBinaryFileReader>> readers;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--color") == 0) {
+            color = true;
+            continue;
+        }
+        auto reader = std::make_unique<ConsoleBinaryFileReader>();
+        if (!reader->Open(argv[i])) {
+            fmt::println(stderr, "{}: not a Kryos binary log file", argv[i]);
+            return 1;
+        }
+        readers.push_back(std::move(reader));
+    }
+    if (readers.empty()) {
+        fmt::println(stderr, "usage: {} [--color] <file.kylog>...", argv[0]);
+        return 1;
+    }
+
+    // Rotated files can be passed in any order
+    std::sort(readers.begin(), readers.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs->Header.Sequence < rhs->Header.Sequence;
+    });
+
+    DecoderOutput output;
+    for (const auto& reader : readers) {
+        uint32_t flags = reader->Header.OutputFlags & ~ConsoleOutput_ColorBit;
+        output.Initialize(color ? flags | ConsoleOutput_ColorBit : flags);
+
+        ConsoleMessage msg;
+        while (reader->Next(msg)) {
+            output.PrintOutput(msg);
+        }
+    }
+}
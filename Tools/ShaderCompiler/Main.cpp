@@ -0,0 +1,216 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Core/Console.h>
+#include <Core/Hash.h>
+#include <Core/JobSystem.h>
+#include <Core/Time.h>
+#include <RHI/ShaderArchive.h>
+#include <RHI/ShaderInclude.h>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+
+// Offline shader build step: expands includes and every permutation of the given shader files
+// across all job workers, preprocesses and validates each variant and packs them into one
+// ShaderArchive. The include graph is kept in <archive>.deps, shaders whose files all hash the
+// same as last time reuse their variants from the previous archive instead of being rebuilt.
+// Everything is rebuilt when the compiler binary or the include directories changed
+//
+//   KryosShaderCompiler -o Shaders.kar [-I <dir>]... [-d <depfile>] Unlit.glsl Lit.glsl
+
+struct CompileItem {
+    uint32_t File;
+    uint32_t Permutation;
+};
+
+// Hash of the running compiler binary, so that variants from any other build count as stale.
+// Empty when the binary can't be read, which never matches
+static std::string ToolVersion(const char* executable)
+{
+    std::string binary;
+    if (!ShaderPreprocessor::ReadFile(executable, binary)) {
+        return std::string();
+    }
+    return fmt::format("{:016x}", HashString(binary));
+}
+
+int main(int argc, char** argv)
+{
+    std::string output_path;
+    std::string depfile_path;
+    std::vector<std::string> input_paths;
+    ShaderPreprocessor preprocessor;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            output_path = argv[++i];
+        }
+        else if (arg == "-d" && i + 1 < argc) {
+            depfile_path = argv[++i];
+        }
+        else if (arg == "-I" && i + 1 < argc) {
+            preprocessor.IncludeDirectories.emplace_back(argv[++i]);
+        }
+        else {
+            input_paths.emplace_back(arg);
+        }
+    }
+    if (output_path.empty() || input_paths.empty()) {
+        fmt::println(stderr, "Usage: {} -o <archive> [-I <dir>]... [-d <depfile>] <shader>...",
+                     argv[0]);
+        return 1;
+    }
+
+    Console console;
+    JobSystem jobs;
+    console.Initialize();
+    console.AddOutput<ConsoleTerminalOutput>();
+    jobs.Initialize();
+    uint64_t start = Time::NowNanoseconds();
+
+    ShaderDependencyGraph graph;
+    graph.ToolVersion        = ToolVersion(argv[0]);
+    graph.IncludeDirectories = preprocessor.IncludeDirectories;
+
+    std::string graph_path = output_path + ".deps";
+    ShaderDependencyGraph previous_graph;
+    ShaderArchive previous_archive;
+    bool incremental = std::filesystem::exists(graph_path) &&
+                       std::filesystem::exists(output_path) && previous_graph.Load(graph_path);
+    if (incremental && (graph.ToolVersion.empty() ||
+                        previous_graph.ToolVersion != graph.ToolVersion ||
+                        previous_graph.IncludeDirectories != graph.IncludeDirectories)) {
+        fmt::println("Rebuilding all shaders, compiler or include directories changed");
+        incremental = false;
+    }
+    incremental = incremental && previous_archive.Load(output_path);
+
+    // Shaders are looked up at runtime by file name without extension
+    std::vector<ShaderSourceFile> files;
+    std::vector<uint32_t> file_nodes;
+    std::vector<ShaderVariant> variants;
+    std::vector<CompileItem> items;
+    uint32_t failed_files = 0;
+    for (const std::string& input_path : input_paths) {
+        std::string name = std::filesystem::path(input_path).stem().string();
+        const ShaderDependencyNode* previous =
+            incremental ? previous_graph.Find(input_path) : nullptr;
+        const std::string* changed =
+            previous != nullptr ? ShaderDependencyGraph::Changed(*previous) : nullptr;
+
+        size_t reused = variants.size();
+        if (previous != nullptr && changed == nullptr) {
+            ShaderProgramDesc desc;
+            for (uint64_t key : previous->Variants) {
+                if (!previous_archive.Find(key, desc)) {
+                    break;
+                }
+                ShaderVariant& variant = variants.emplace_back();
+                variant.Key            = key;
+                for (const ShaderStageSource& stage : desc.Stages) {
+                    variant.Stages.push_back(
+                        ShaderSourceStage {stage.Stage, std::string(stage.Source), 0, 0});
+                }
+            }
+            if (variants.size() - reused == previous->Variants.size()) {
+                graph.Nodes.push_back(*previous);
+                continue;
+            }
+            variants.resize(reused);
+        }
+        if (changed != nullptr) {
+            fmt::println("Rebuilding {}, '{}' changed", name, *changed);
+        }
+
+        std::string text;
+        std::string error;
+        ShaderDependencyNode& node = graph.Nodes.emplace_back();
+        ShaderSourceFile& file     = files.emplace_back();
+        if (!preprocessor.Expand(input_path, text, node.Dependencies, node.Absent, error) ||
+            !file.Parse(name, text, error)) {
+            // Dropped so files and file_nodes keep indexing the same shaders
+            fmt::println(stderr, "{}", error);
+            files.pop_back();
+            graph.Nodes.pop_back();
+            failed_files++;
+            continue;
+        }
+
+        node.Shader = node.Dependencies[0].Path;
+        for (const ShaderDependency& dependency : node.Dependencies) {
+            file.SourceNames.push_back(dependency.Path);
+        }
+        file_nodes.push_back((uint32_t)graph.Nodes.size() - 1);
+
+        uint32_t count = file.PermutationCount();
+        for (uint32_t permutation = 0; permutation < count; permutation++) {
+            items.push_back(CompileItem {(uint32_t)files.size() - 1, permutation});
+        }
+    }
+
+    size_t reused_count = variants.size();
+    variants.resize(reused_count + items.size());
+    std::vector<std::string> errors(items.size());
+    if (failed_files == 0 && !items.empty()) {
+        auto build = [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                ShaderVariant& variant = variants[reused_count + i];
+                files[items[i].File].BuildVariant(items[i].Permutation, variant, errors[i]);
+            }
+        };
+        Job* job = JobSystem::ParallelFor((uint32_t)items.size(), 16, build);
+        JobSystem::Run(job);
+        JobSystem::Wait(job);
+    }
+
+    // Nothing was built when a file failed, so there are no variants to record
+    uint32_t failed = 0;
+    for (uint32_t i = 0; failed_files == 0 && i < errors.size(); i++) {
+        if (!errors[i].empty() && failed++ < 16) {
+            std::vector<std::string_view> keywords;
+            files[items[i].File].PermutationKeywords(items[i].Permutation, keywords);
+            fmt::println(stderr, "{} [{}]", errors[i], fmt::join(keywords, " "));
+        }
+        else if (errors[i].empty()) {
+            ShaderDependencyNode& node = graph.Nodes[file_nodes[items[i].File]];
+            node.Variants.push_back(variants[reused_count + i].Key);
+        }
+    }
+
+    int64_t sources = -1;
+    if (failed_files == 0 && failed == 0) {
+        sources = ShaderArchive::Write(output_path, variants);
+    }
+    if (sources >= 0) {
+        graph.Save(graph_path);
+        if (!depfile_path.empty()) {
+            graph.WriteDepfile(depfile_path, output_path);
+        }
+    }
+    double ms = (double)(Time::NowNanoseconds() - start) * 1e-6;
+
+    jobs.Destroy();
+    console.Destroy();
+    if (sources < 0) {
+        fmt::println(stderr, "{} of {} shaders and {} of {} variants failed, '{}' not written",
+                     failed_files, input_paths.size(), failed, items.size(), output_path);
+        return 1;
+    }
+    fmt::println("{} shaders, {} variants ({} rebuilt), {} unique stage sources -> '{}' in "
+                 "{:.1f}ms",
+                 input_paths.size(), variants.size(), items.size(), sources, output_path, ms);
+    return 0;
+}
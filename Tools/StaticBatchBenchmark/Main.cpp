@@ -0,0 +1,194 @@
+// This file is part of https://github.com/Oniup/KryosEngine
+// Copyright (c) 2024 Oniup (https://github.com/Oniup)
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Core/Time.h>
+#include <RHI/StaticBatch.h>
+#include <algorithm>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <random>
+
+// Builds indirect draws for the visible half of a synthetic scene of static objects and compares
+// it against recording one bind and draw per object, the path the batch replaces
+
+struct Vertex {
+    float Position[3];
+    float Normal[3];
+    float Uv[2];
+};
+
+static void GenerateMeshes(StaticGeometryPool& pool, uint32_t mesh_count)
+{
+    std::mt19937 rng(42);
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    for (uint32_t mesh = 0; mesh < mesh_count; mesh++) {
+        uint32_t quad_count = 8 + rng() % 248;
+        vertices.assign(quad_count * 4, Vertex {});
+        indices.clear();
+        for (uint32_t quad = 0; quad < quad_count; quad++) {
+            uint32_t base = quad * 4;
+            indices.insert(indices.end(), {base, base + 1, base + 2, base + 2, base + 3, base});
+        }
+        pool.AddMesh(vertices.data(), (uint32_t)vertices.size(), indices.data(),
+                     (uint32_t)indices.size());
+    }
+}
+
+static std::vector<StaticObject> GenerateObjects(uint32_t count, uint32_t mesh_count)
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position_dist(-500.0f, 500.0f);
+
+    std::vector<StaticObject> objects(count);
+    for (uint32_t i = 0; i < count; i++) {
+        StaticInstanceData data = {};
+        data.Transform[0]       = 1.0f;
+        data.Transform[3]       = position_dist(rng);
+        data.Transform[5]       = 1.0f;
+        data.Transform[7]       = position_dist(rng);
+        data.Transform[10]      = 1.0f;
+        data.Transform[11]      = position_dist(rng);
+        data.Material           = rng() % 256;
+        data.Object             = i;
+        objects[i]              = StaticObject {(uint32_t)(rng() % mesh_count), data};
+    }
+    return objects;
+}
+
+// Every instance sits in its mesh's command and the commands cover each visible object once
+static bool Valid(const StaticBatch& batch, const StaticGeometryPool& pool,
+                  const std::vector<StaticObject>& objects, uint32_t visible_count)
+{
+    uint32_t instance_count = 0;
+    for (const RenderDrawIndexedIndirectArgs& command : batch.Commands) {
+        for (uint32_t i = 0; i < command.InstanceCount; i++) {
+            const StaticInstanceData& data = batch.Instances[command.FirstInstance + i];
+            const StaticMeshRange& range   = pool.Meshes[objects[data.Object].Mesh];
+            if (range.FirstIndex != command.FirstIndex) {
+                return false;
+            }
+        }
+        instance_count += command.InstanceCount;
+    }
+    return instance_count == visible_count && batch.Instances.size() == visible_count;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t object_count = argc > 1 ? (uint32_t)std::strtoul(argv[1], nullptr, 10) : 100000;
+    uint32_t mesh_count   = argc > 2 ? (uint32_t)std::strtoul(argv[2], nullptr, 10) : 256;
+    uint32_t iterations   = argc > 3 ? (uint32_t)std::strtoul(argv[3], nullptr, 10) : 20;
+
+    StaticGeometryPool pool;
+    pool.Initialize(sizeof(Vertex));
+    GenerateMeshes(pool, std::max(mesh_count, 1u));
+#ifdef KRYOS_RHI_NULL
+    // The OpenGL backend needs a current context to create buffers, map the upload ring and
+    // replay, see KryosEditor. Only building the indirect arguments is timed there
+    pool.Upload();
+#endif
+
+    uint32_t pool_meshes              = (uint32_t)pool.Meshes.size();
+    std::vector<StaticObject> objects = GenerateObjects(object_count, pool_meshes);
+    std::vector<uint32_t> visible;
+    std::mt19937 rng(99);
+    for (uint32_t i = 0; i < object_count; i++) {
+        if (rng() % 2 == 0) {
+            visible.push_back(i);
+        }
+    }
+    uint32_t visible_count = (uint32_t)visible.size();
+
+    StaticBatch batch;
+    RenderCommandBuffer batched;
+    RenderCommandBuffer per_object;
+    uint64_t build_ns             = 0;
+    uint64_t record_batched_ns    = 0;
+    uint64_t record_per_object_ns = 0;
+    uint64_t execute_batched_ns   = 0;
+    uint64_t execute_object_ns    = 0;
+    bool valid                    = true;
+
+#ifdef KRYOS_RHI_NULL
+    RenderUploadRing uploads;
+    uploads.Initialize((uint64_t)object_count * sizeof(StaticInstanceData) +
+                           (uint64_t)pool.Meshes.size() * sizeof(RenderDrawIndexedIndirectArgs),
+                       1);
+#endif
+
+    for (uint32_t iteration = 0; iteration < iterations; iteration++) {
+        uint64_t start = Time::NowNanoseconds();
+        batch.Build(pool, objects.data(), visible.data(), visible_count);
+        build_ns += Time::NowNanoseconds() - start;
+        valid = valid && Valid(batch, pool, objects, visible_count);
+
+        // Each object binds its own slice of an instance buffer and draws its mesh
+        per_object.Reset();
+        start = Time::NowNanoseconds();
+        per_object.BindVertexArray(1);
+        per_object.BindVertexBuffer(0, pool.VertexBuffer, pool.VertexStride);
+        per_object.BindBuffer(RenderBufferTarget_Index, pool.IndexBuffer);
+        for (uint32_t i = 0; i < visible_count; i++) {
+            const StaticObject& object   = objects[visible[i]];
+            const StaticMeshRange& range = pool.Meshes[object.Mesh];
+            per_object.BindBuffer(RenderBufferTarget_Uniform, 1, StaticBatch::InstanceSlot,
+                                  (uint64_t)i * 256, sizeof(StaticInstanceData));
+            per_object.DrawIndexed(range.IndexCount, 1, range.FirstIndex, range.BaseVertex);
+        }
+        record_per_object_ns += Time::NowNanoseconds() - start;
+
+#ifdef KRYOS_RHI_NULL
+        uploads.BeginFrame();
+        batched.Reset();
+        start = Time::NowNanoseconds();
+        valid = batch.Record(batched, uploads, pool, 1) && valid;
+        record_batched_ns += Time::NowNanoseconds() - start;
+        uploads.EndFrame();
+
+        start = Time::NowNanoseconds();
+        per_object.Execute();
+        execute_object_ns += Time::NowNanoseconds() - start;
+
+        start = Time::NowNanoseconds();
+        batched.Execute();
+        execute_batched_ns += Time::NowNanoseconds() - start;
+#endif
+    }
+
+    auto ms = [&](uint64_t ns) { return (double)ns / iterations / 1e6; };
+    fmt::println("{} objects, {} visible, {} meshes, {} iterations", object_count,
+                 visible_count, pool.Meshes.size(), iterations);
+    fmt::println("{:<24} {:>8.3f} ms", "build indirect", ms(build_ns));
+    fmt::println("{:<24} {:>8.3f} ms", "record per object", ms(record_per_object_ns));
+#ifdef KRYOS_RHI_NULL
+    fmt::println("{:<24} {:>8.3f} ms", "record batched", ms(record_batched_ns));
+    fmt::println("{:<24} {:>8.3f} ms", "execute per object", ms(execute_object_ns));
+    fmt::println("{:<24} {:>8.3f} ms", "execute batched", ms(execute_batched_ns));
+    fmt::println("{:<24} {:>8} -> {}", "commands", per_object.CommandCount,
+                 batched.CommandCount);
+    uploads.Destroy();
+#else
+    (void)record_batched_ns;
+    (void)execute_batched_ns;
+    (void)execute_object_ns;
+    fmt::println("{:<24} {:>8} -> {}", "draw calls", visible_count, 1);
+#endif
+    fmt::println("{:<24} {:>8}", "indirect commands", batch.Commands.size());
+    fmt::println("{:<24} {:>8}", "valid", valid ? "yes" : "NO");
+
+    pool.Destroy();
+    return valid ? 0 : 1;
+}